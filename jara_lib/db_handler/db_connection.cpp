@@ -1,5 +1,7 @@
 #include "db_connection.h"
 
+#include <QAtomicInt>
+
 namespace jara_lib {
     /* Конструктор принимает строку подключения */
     DbConnection::DbConnection(const QString& connectionString, DbType type)
@@ -90,6 +92,15 @@ namespace jara_lib {
          * драйвер для подключения. Соответственно, для использования драйвер должен
          * быть предварительно установлен на компьютер. Исключение - sqlite.
          */
+        /*
+         * Каждое подключение регистрируется в QSqlDatabase под своим именем:
+         * подключение с тем же именем заменило бы собой открытое, в том
+         * числе в другом потоке.
+         */
+        static QAtomicInt connectionCount;
+        const QString &connectionName = "jara_connection_" +
+            QString::number(connectionCount.fetchAndAddOrdered(1) + 1);
+
         switch (_dbType) {
         /*
          * В ветках для MySQL/PostgreSQL/MS SQL Server задаются параметры подключения:
@@ -104,26 +115,28 @@ namespace jara_lib {
          * первом обращении к ней с именем, указанным в строке подключения.
          */
             case DbType::MYSQL:
-                _db = QSqlDatabase::addDatabase("QMYSQL");
+                _db = QSqlDatabase::addDatabase("QMYSQL", connectionName);
                 _dbMasterName = "INFORMATION_SCHEMA";
                 _dbPort = (_dbPort == 0) ? 3306 : _dbPort;
                 Command = std::make_shared<MysqlCommand>();
                 break;
             case DbType::POSTGRES:
-                _db = QSqlDatabase::addDatabase("QPSQL");
+                _db = QSqlDatabase::addDatabase("QPSQL", connectionName);
                 _dbMasterName = "postgres";
                 _dbPort = (_dbPort == 0) ? 5432 : _dbPort;
                 Command = std::make_shared<PgsqlCommand>();
                 break;
             case DbType::ODBC:
-                _db = QSqlDatabase::addDatabase("QODBC3");
+                _db = QSqlDatabase::addDatabase("QODBC3", connectionName);
                 _dbMasterName = _dbConnectionString;
                 _dbMasterName.replace(_dbName, "master");
                 _dbPort = (_dbPort == 0) ? 1433 : _dbPort;
                 Command = std::make_shared<MssqlCommand>();
                 break;
             case DbType::SQLITE:
-                _db = QSqlDatabase::addDatabase("QSQLITE");
+                _db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+                _dbMasterName = _dbConnectionString;
+                Command = std::make_shared<SqliteCommand>();
                 break;
         }
         _dbCurrentConnection = ConnectionType::CONNECTION_REFUSED;
@@ -273,7 +286,16 @@ namespace jara_lib {
         }
     }
 
-    QSqlQuery DbConnection::proceedQuery(const QString &command, bool master) {
+    /* Метод подготовки подключения к главной базе или к базе приложения */
+    bool DbConnection::connectionReady(bool master) {
+        // Если уже подключены к нужной базе, то используем открытое соединение:
+        // повторное открытие начинает новую сессию в СУБД
+        if (_db.isOpen() &&
+            ((master && _dbCurrentConnection == MASTER_DB_CONNECTION) ||
+             (!master && _dbCurrentConnection == APPLICATION_DB_CONNECTION))) {
+            return true;
+        }
+
         if ((master && _dbCurrentConnection != MASTER_DB_CONNECTION) ||
             (!master && _dbCurrentConnection != APPLICATION_DB_CONNECTION) ||
             (_db.isOpen() && _dbCurrentConnection == CONNECTION_REFUSED)) {
@@ -281,12 +303,153 @@ namespace jara_lib {
         }
 
         _dbCurrentConnection = openConnection(master);
+        return (_dbCurrentConnection != CONNECTION_REFUSED && _db.isOpen() &&
+                ((master && _dbCurrentConnection == MASTER_DB_CONNECTION) ||
+                 (!master && _dbCurrentConnection == APPLICATION_DB_CONNECTION)));
+    }
+
+    /*
+     * Для запросов, результат которых читается только последовательно,
+     * ставится признак forwardOnly: драйвер не держит все прочитанные
+     * записи для произвольного доступа к ним.
+     */
+    QSqlQuery DbConnection::proceedQuery(const QString &command, bool master,
+                                         bool forwardOnly) {
+        bool ready = connectionReady(master);
         QSqlQuery query(_db);
-        if (_dbCurrentConnection != CONNECTION_REFUSED && _db.isOpen() &&
-            ((master && _dbCurrentConnection == MASTER_DB_CONNECTION) ||
-             (!master && _dbCurrentConnection == APPLICATION_DB_CONNECTION))) {
+        query.setForwardOnly(forwardOnly);
+        if (!ready) {
+            return query;
+        }
+
+        // QSQLITE выполняет только первую команду составного запроса
+        if (_dbType != DbType::SQLITE) {
             query.exec(command);
+            return query;
+        }
+        for (const QString &part : splitCommands(command)) {
+            query = QSqlQuery(_db);
+            query.setForwardOnly(forwardOnly);
+            if (!query.exec(part)) {
+                break;
+            }
         }
         return query;
     }
+
+    /*
+     * Команды разделяются точкой с запятой вне строк и имён в кавычках,
+     * пустые команды пропускаются.
+     */
+    QVector<QString> DbConnection::splitCommands(const QString &command) {
+        QVector<QString> commands;
+        QChar quote;
+        int from = 0;
+        for (int index = 0; index <= command.size(); ++index) {
+            const QChar symbol = (index < command.size())
+                ? command[index] : QChar(';');
+            if (quote != QChar()) {
+                if (symbol == quote) {
+                    quote = QChar();
+                }
+            }
+            else if (symbol == '\'' || symbol == '"') {
+                quote = symbol;
+            }
+            else if (symbol == ';') {
+                const QString &part = command.mid(from, index - from).trimmed();
+                if (!part.isEmpty()) {
+                    commands.append(part);
+                }
+                from = index + 1;
+            }
+        }
+        return commands;
+    }
+
+    /*
+     * Выполнение подготовленного запроса с позиционными параметрами.
+     * Значения передаются драйверу отдельно от текста запроса, поэтому
+     * одна и та же строка команды годится для любых данных.
+     */
+    QSqlQuery DbConnection::proceedQuery(const QString &command,
+                                         const QVector<QVariant> &values) {
+        bool ready = connectionReady(false);
+        QSqlQuery query(_db);
+        if (ready && query.prepare(command)) {
+            for (const QVariant &value : values) {
+                query.addBindValue(value);
+            }
+            query.exec();
+        }
+        return query;
+    }
+
+    int DbConnection::insertKeyIncrement() {
+        if (_insertKeyIncrement > 0) {
+            return _insertKeyIncrement;
+        }
+
+        const QString &command = Command->insertKeyIncrement();
+        if (command.isEmpty()) {
+            _insertKeyIncrement = 1;
+            return _insertKeyIncrement;
+        }
+
+        // Без известного шага ключи вставленных записей не вычислить
+        QSqlQuery query = proceedQuery(command);
+        if (query.first() && query.value(0).toInt() > 0) {
+            _insertKeyIncrement = query.value(0).toInt();
+        }
+        return _insertKeyIncrement;
+    }
+
+    /*
+     * Транзакции могут быть вложенными: в СУБД транзакция начинается
+     * при первом вызове и завершается, когда завершена внешняя.
+     */
+    bool DbConnection::beginTransaction() {
+        if (_transactionDepth > 0) {
+            ++_transactionDepth;
+            return true;
+        }
+
+        if (connectionReady(false) && _db.transaction()) {
+            _transactionDepth = 1;
+            return true;
+        }
+        return false;
+    }
+
+    bool DbConnection::commitTransaction() {
+        if (_transactionDepth == 0) {
+            return false;
+        }
+
+        if (--_transactionDepth > 0) {
+            return true;
+        }
+
+        // Вложенная транзакция была отменена: отменяется и внешняя
+        if (_rollbackOnly) {
+            _rollbackOnly = false;
+            _db.rollback();
+            return false;
+        }
+        return _db.commit();
+    }
+
+    bool DbConnection::rollbackTransaction() {
+        if (_transactionDepth == 0) {
+            return false;
+        }
+
+        if (--_transactionDepth > 0) {
+            _rollbackOnly = true;
+            return true;
+        }
+
+        _rollbackOnly = false;
+        return _db.rollback();
+    }
 };
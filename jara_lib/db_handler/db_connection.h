@@ -5,6 +5,7 @@
 #include "db_pgsql_querye.h"
 #include "db_mysql_querye.h"
 #include "db_mssql_query.h"
+#include "db_sqlite_query.h"
 
 namespace jara_lib {
     /*! Класс подключения к базе данных */
@@ -47,10 +48,32 @@ namespace jara_lib {
         void setDbParams();
         /*! Метод для парсинга строки подключения (DbConnection) */
         void connectionStringParser();
+        /*! Подготовка подключения перед выполнением запроса (DbConnection) */
+        bool connectionReady(bool master);
+        /*! Деление составного запроса на отдельные команды (DbConnection) */
+        static QVector<QString> splitCommands(const QString &command);
 
     public:
         /*! Выполнить запрос (DbConnection) */
-        QSqlQuery proceedQuery(const QString&, bool master = false);
+        QSqlQuery proceedQuery(const QString&, bool master = false,
+                               bool forwardOnly = false);
+        /*! Выполнить запрос с привязкой значений к параметрам (DbConnection) */
+        QSqlQuery proceedQuery(const QString&, const QVector<QVariant>&);
+        /*! Начать транзакцию в базе приложения (DbConnection) */
+        bool beginTransaction();
+        /*! Завершить транзакцию в базе приложения (DbConnection) */
+        bool commitTransaction();
+        /*!
+         *  Отменить транзакцию (DbConnection). Вложенная транзакция только
+         *  уменьшает глубину вложенности и отмечает внешнюю транзакцию
+         *  для отмены: её завершение отменит транзакцию в базе.
+         */
+        bool rollbackTransaction();
+        /*!
+         *  Шаг значений ключей-счётчиков (DbConnection): читается из СУБД
+         *  один раз за время жизни подключения, 0 - шаг не получен.
+         */
+        int insertKeyIncrement();
         QString getDbName() const { return _dbName; }
         DbType getDbType() const { return _dbType; }
 
@@ -77,6 +100,12 @@ namespace jara_lib {
         QSqlDatabase _db;
         //! Состояние подключения к базе данны (DbConnection)
         ConnectionType _dbCurrentConnection;
+        //! Глубина вложенности транзакций (DbConnection)
+        int _transactionDepth = 0;
+        //! Внешняя транзакция должна быть отменена (DbConnection)
+        bool _rollbackOnly = false;
+        //! Шаг значений ключей-счётчиков, 0 - ещё не прочитан (DbConnection)
+        int _insertKeyIncrement = 0;
     };
 };
 
@@ -6,8 +6,11 @@ HEADERS += \
     $$PWD/db_mssql_query.h \
     $$PWD/db_mysql_querye.h \
     $$PWD/db_pgsql_querye.h \
-    $$PWD/db_query_interface.h
+    $$PWD/db_query_interface.h \
+    $$PWD/db_record_cursor.h \
+    $$PWD/db_sqlite_query.h
 
 SOURCES += \
     $$PWD/db_connection.cpp \
-    $$PWD/db_model_interface.cpp
+    $$PWD/db_model_interface.cpp \
+    $$PWD/db_record_cursor.cpp
@@ -19,8 +19,9 @@ namespace jara_lib {
         { ColumnOperator::GREATER, ">" },
         { ColumnOperator::LESSOREQ, "<=" },
         { ColumnOperator::LESS, "<" },
+        { ColumnOperator::IN, "IN" },
+        { ColumnOperator::NOTIN, "NOT IN" },
+        { ColumnOperator::EXISTS, "EXISTS" },
+        { ColumnOperator::NOTEXISTS, "NOT EXISTS" },
     };
-
-    TableRegister IEntityModel::_register_tables_;
-    ColumnRegister IEntityModel::_register_columns_;
 }
@@ -12,6 +12,8 @@
 #include <memory>
 #include <QSet>
 #include <QPair>
+#include <QMutex>
+#include <QReadWriteLock>
 #include <QVariant>
 #include <QSqlQuery>
 #include <QSharedPointer>
@@ -21,6 +23,8 @@ namespace jara_lib {
      * Для итерации по возвращаемым коллекциям указателей из методов.
      * Без этой функции выйдет warning:
      * Using C++11 range-based for loop correctly in Qt
+     * Коллекция, возвращаемая по ссылке, не копируется (T - ссылочный тип),
+     * временная коллекция перемещается в возвращаемое значение.
      */
     template <class T>
     T const as_const(T &&t) { return std::forward<T>(t); }
@@ -35,7 +39,8 @@ namespace jara_lib {
     enum ColumnOperator : ushort {
         OR, AND, EQUAL, NOTEQUAL,
         GREATEROREQ, GREATER,
-        LESSOREQ, LESS
+        LESSOREQ, LESS,
+        IN, NOTIN, EXISTS, NOTEXISTS
     };
 
     /*!
@@ -115,16 +120,27 @@ namespace jara_lib {
     using DbTables = QSet<DbTable>;
     // Указатель на модель колонки
     using DbColumn = IColumnModel*;
-    // Множество указателей на колонки
-    using DbColumns = QSet<DbColumn>;
+    // Колонки таблицы в порядке объявления
+    using DbColumns = QVector<DbColumn>;
     // Указатель на тип контекста
     using DbContext = IModelContext*;
+    // Невиртуальная функция записи значения результата в колонку
+    using ColumnDecoder = void (*)(DbColumn, const QVariant&);
+
+    /*!
+     *  Значения ключа у всех записей одного результата запроса и
+     *  загруженные по ним данные. Разделяется колонкой всех этих записей,
+     *  чтобы первое обращение загрузило данные сразу для всего результата:
+     *  для вторичного ключа - связанные записи (rows) по его значениям,
+     *  для отложенной колонки - её значения (values) по первичному ключу.
+     */
+    struct ReferenceGroup {
+        QVector<QVariant> keys;
+        QHash<qlonglong, QSharedPointer<ITableModel>> rows;
+        QHash<qlonglong, QVariant> values;
+        bool loaded = false;
+    };
 
-    // Реестр для хранение имен таблиц и колонок, определяемых через
-    // структуры, которые реализуют таблицы и колонки в коде
-    using TableRegister = std::map<QString, DbTables>;
-    using TableColumn = std::pair<QString*, QString>;
-    using ColumnRegister = std::map<TableColumn, DbColumns>;
     // Коллекция из вторичных ключей для связей между таблицами
     using ForeignKeys = QVector<QPair<DbTable, DbColumn>>;
     // Таблица из типа запроса SQL и коллекции получаемых полей
@@ -137,10 +153,6 @@ namespace jara_lib {
         virtual QString getModelName() const = 0;
         //! Метод для задания имени модели (IEntityModel)
         virtual void setModelName(const QString&) = 0;
-
-    protected:
-        static TableRegister _register_tables_;
-        static ColumnRegister _register_columns_;
     };
 
     //! Интерфейс модели таблиц
@@ -160,7 +172,9 @@ namespace jara_lib {
         //! Получение вторичных ключей данной таблицы (ITableModel)
         virtual ForeignKeys getFkColumns() const = 0;
         //! Получение коллекции колонок (ITableModel)
-        virtual DbColumns getTableColumns() const = 0;
+        virtual const DbColumns& getTableColumns() const = 0;
+        //! Получение колонки по её имени (ITableModel)
+        virtual DbColumn getColumn(const QString&) const = 0;
 
     protected:
         //! Флаг состояния значения в таблице (ITableModel)
@@ -184,6 +198,38 @@ namespace jara_lib {
         virtual void setModelValue(const QVariant&) = 0;
         //! Изменить значение колонки (IColumnModel)
         virtual void changeModelValue(const QVariant&) = 0;
+        //! Размер блока ключей, резервируемых за один запрос (IColumnModel)
+        virtual int getKeyBlockSize() const = 0;
+        //! Получение состояния значения колонки (IColumnModel)
+        virtual ValueState getValueState() const = 0;
+        //! Задать состояние значения колонки (IColumnModel)
+        virtual void setValueState(ValueState) = 0;
+        //! Значение колонки NULL (IColumnModel)
+        virtual bool isNull() const = 0;
+        //! Функция записи значения результата для типа колонки (IColumnModel)
+        virtual ColumnDecoder getDecoder() const = 0;
+        //! Копировать значение колонки того же типа без QVariant (IColumnModel)
+        virtual void copyValue(DbColumn source) = 0;
+        //! Перенести значение колонки того же типа без QVariant (IColumnModel)
+        virtual void moveValue(DbColumn source) = 0;
+        //! Связать вторичный ключ с объектом записи, на которую он ссылается (IColumnModel)
+        virtual void setReference(const QSharedPointer<ITableModel>&) = 0;
+        //! Получение объекта записи, на которую ссылается вторичный ключ (IColumnModel)
+        virtual QSharedPointer<ITableModel> getReference() const = 0;
+        //! Связать вторичный ключ с ключами записей того же результата (IColumnModel)
+        virtual void setReferenceGroup(const QSharedPointer<ReferenceGroup>&) = 0;
+        //! Получение ключей записей того же результата (IColumnModel)
+        virtual QSharedPointer<ReferenceGroup> getReferenceGroup() const = 0;
+        //! Таблица, на которую ссылается вторичный ключ (IColumnModel)
+        virtual DbTable getReferencedTable() const = 0;
+        //! Колонка не выбирается по умолчанию и загружается при обращении (IColumnModel)
+        virtual bool isDeferred() const = 0;
+        //! Значение колонки прочитано из базы или задано в программе (IColumnModel)
+        virtual bool isLoaded() const = 0;
+        //! Отметить значение отложенной колонки загруженным или нет (IColumnModel)
+        virtual void setLoaded(bool) = 0;
+        //! Равные значения колонки в результате запроса разделяют одну строку (IColumnModel)
+        virtual bool isInterned() const = 0;
 
     protected:
         //! Флаг состояния значения в заданной ячейке (IColumnModel)
@@ -193,8 +239,23 @@ namespace jara_lib {
     class IModelContext {
     public:
         virtual void registerTable(const DbTable&) = 0;
+        virtual QString prepareExpression(
+            const IExpressionHandler &expression) const = 0;
         virtual QSqlQuery proceedExpression(
-            const IExpressionHandler &expression) = 0;
+            const IExpressionHandler &expression,
+            bool forwardOnly = false) = 0;
+        virtual QString openCursor(const IExpressionHandler &expression) = 0;
+        virtual QSqlQuery fetchCursor(const QString &cursor, int fetchSize) = 0;
+        virtual void closeCursor(const QString &cursor) = 0;
+        virtual bool proceedInsert(const QVector<DbTable> &rows) = 0;
+        virtual bool proceedUpdate(const QVector<DbTable> &rows) = 0;
+        virtual void attach(const DbTable &row) = 0;
+        virtual void detach(const DbTable &row) = 0;
+        virtual QSharedPointer<ITableModel> findRow(
+            const QString &tableName, qlonglong key) const = 0;
+        virtual QSharedPointer<ITableModel> registerRow(
+            const QSharedPointer<ITableModel> &row) = 0;
+        virtual void assignKey(const DbTable &row) = 0;
         virtual DbType getDbType() const = 0;
         virtual void dbInit() = 0;
         virtual void migrate() = 0;
@@ -203,6 +264,8 @@ namespace jara_lib {
     class IExpressionHandler {
     public:
         virtual void setQueryTable(const DbTable&) = 0;
+        virtual DbTable getQueryTable() const = 0;
         virtual const ExpressionNodes getExpressionNodes() const = 0;
+        virtual int getFetchSize() const = 0;
     };
 };
@@ -272,6 +272,122 @@ namespace jara_lib {
             return wrapQuery(queryCommand);
         }
 
+        /*!
+         *  Строка запроса для вставки нескольких записей (MssqlCommand);
+         *  Порядок строк OUTPUT не гарантируется, поэтому при возврате
+         *  ключей записи вставляются через MERGE: каждая запись источника
+         *  получает номер, и OUTPUT возвращает его вместе с ключом.
+         *  Запрос не оборачивается в BEGIN ... END, иначе драйвер
+         *  не получит набор записей с ключами.
+         */
+        QString insertRows(const DbTable &table,
+                           const QVector<DbColumn> &columns,
+                           int rowCount,
+                           const DbColumn &keyColumn = nullptr) const override {
+            if (!keyColumn) {
+                QString queryCommand = "INSERT INTO " + table->getModelName();
+                queryCommand += " (" + prepareColumnNames(columns) + ") ";
+                queryCommand += "VALUES " + prepareRowValues(columns.count(), rowCount);
+                return queryCommand;
+            }
+
+            QString rowParameters = "";
+            QString sourceValues = "";
+            for (const DbColumn &column : columns) {
+                rowParameters += ", ?";
+                sourceValues += (sourceValues.isEmpty()) ? "" : ", ";
+                sourceValues += "jara_values." + column->getModelName();
+            }
+
+            QString queryCommand = "MERGE INTO " + table->getModelName();
+            queryCommand += " USING (VALUES ";
+            for (int row = 0; row < rowCount; ++row) {
+                queryCommand += (row) ? ", (" : "(";
+                queryCommand += QString::number(row) + rowParameters + ")";
+            }
+            queryCommand += ") AS jara_values (jara_ordinal";
+            queryCommand += (columns.isEmpty()) ? "" : ", " + prepareColumnNames(columns);
+            queryCommand += ") ON 1 = 0 WHEN NOT MATCHED THEN INSERT ";
+            queryCommand += (columns.isEmpty())
+                ? QString("DEFAULT VALUES")
+                : "(" + prepareColumnNames(columns) + ") VALUES (" + sourceValues + ")";
+            queryCommand += " OUTPUT jara_values.jara_ordinal, INSERTED.";
+            queryCommand += keyColumn->getModelName() + ";";
+            return queryCommand;
+        }
+
+        bool returnsInsertedKeys() const override
+        { return true; }
+
+        bool returnsKeyOrdinals() const override
+        { return true; }
+
+        /*!
+         *  Строка запроса для изменения нескольких записей (MssqlCommand):
+         *  UPDATE ... FROM с соединением с конструктором VALUES.
+         */
+        QString updateRows(const DbTable &table,
+                           const DbColumn &keyColumn,
+                           const QVector<DbColumn> &columns,
+                           int rowCount) const override {
+            const QString &tableName = table->getModelName();
+            const QString &keyName = keyColumn->getModelName();
+
+            QString queryCommand = "UPDATE " + tableName + " SET ";
+            for (int index = 0; index < columns.count(); ++index) {
+                const QString &columnName = columns[index]->getModelName();
+                queryCommand += (index) ? ", " : "";
+                queryCommand += columnName + " = jara_values." + columnName;
+            }
+            queryCommand += " FROM " + tableName + " INNER JOIN (VALUES ";
+            queryCommand += prepareRowValues(columns.count() + 1, rowCount);
+            queryCommand += ") AS jara_values (" + keyName;
+            queryCommand += ", " + prepareColumnNames(columns) + ")";
+            queryCommand += " ON " + tableName + "." + keyName;
+            queryCommand += " = jara_values." + keyName;
+            return queryCommand;
+        }
+
+        QString createKeySequence(const DbColumn &keyColumn,
+                                  int) const override {
+            const QString &tableName = keyColumn->getTable()->getModelName();
+
+            QString queryCommand = "IF OBJECT_ID(\'" + KeySequenceTable;
+            queryCommand += "\', \'U\') IS NULL CREATE TABLE " + KeySequenceTable;
+            queryCommand += " (TableName NVARCHAR(128) NOT NULL PRIMARY KEY, ";
+            queryCommand += "NextKey BIGINT NOT NULL); ";
+            queryCommand += "IF NOT EXISTS (SELECT 1 FROM " + KeySequenceTable;
+            queryCommand += " WHERE TableName = \'" + tableName + "\') ";
+            queryCommand += "INSERT INTO " + KeySequenceTable;
+            queryCommand += " (TableName, NextKey) VALUES (\'" + tableName + "\', 1); ";
+            // Следующий ключ не меньше MAX(ключ) + 1 (см. IDbCommand)
+            queryCommand += "UPDATE " + KeySequenceTable + " SET NextKey = ";
+            queryCommand += "(SELECT CASE WHEN ISNULL(MAX(" + keyColumn->getModelName();
+            queryCommand += "), 0) + 1 > NextKey THEN ISNULL(MAX(";
+            queryCommand += keyColumn->getModelName() + "), 0) + 1 ELSE NextKey END";
+            queryCommand += " FROM " + tableName + ") WHERE TableName = \'";
+            queryCommand += tableName + "\'; ";
+            return wrapQuery(queryCommand);
+        }
+
+        // Прежнее значение счётчика и есть первый ключ блока
+        QVector<QString> reserveKeys(const DbColumn &keyColumn,
+                                     int blockSize) const override {
+            QString queryCommand = "UPDATE " + KeySequenceTable;
+            queryCommand += " SET NextKey = NextKey + " + QString::number(blockSize);
+            queryCommand += " OUTPUT DELETED.NextKey WHERE TableName = \'";
+            queryCommand += keyColumn->getTable()->getModelName() + "\'";
+            return QVector<QString>() << queryCommand;
+        }
+
+        // MS SQL Server принимает не более 2100 параметров в запросе
+        int maxBoundValues() const override
+        { return 2000; }
+
+        // и не более 1000 записей в конструкторе VALUES
+        int maxInsertRows() const override
+        { return 1000; }
+
         QString getTableColumns(const QString &dbName,
                                 const DbTable &table) const override {
             QString queryCommand = "USE " + dbName + " ";
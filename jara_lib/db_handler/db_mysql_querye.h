@@ -11,6 +11,13 @@ namespace jara_lib {
             ColumnTypes[ColumnType::STRING_NULL] = "TEXT NULL";
         }
 
+        /*
+         * Ключи записей одного запроса идут с шагом
+         * auto_increment_increment (например, при репликации master-master).
+         */
+        QString insertKeyIncrement() const override
+        { return "SELECT @@auto_increment_increment"; }
+
         QString checkDatabase(const QString &dbName) const override {
             QString queryCommand = "SELECT * FROM INFORMATION_SCHEMA.SCHEMATA";
             queryCommand += " WHERE SCHEMA_NAME";
@@ -236,6 +236,137 @@ namespace jara_lib {
             return queryCommand;
         }
 
+        QString insertRows(const DbTable &table,
+                           const QVector<DbColumn> &columns,
+                           int rowCount,
+                           const DbColumn &keyColumn = nullptr) const override {
+            QString queryCommand = "INSERT INTO \"" + table->getModelName() + "\" ";
+            queryCommand += "(" + prepareColumnNames(columns) + ") ";
+            queryCommand += "VALUES " + prepareRowValues(columns.count(), rowCount);
+            // Ключи возвращаются в том же порядке, в котором перечислены записи
+            if (keyColumn) {
+                queryCommand += " RETURNING \"" + keyColumn->getModelName() + "\"";
+            }
+            return queryCommand;
+        }
+
+        bool returnsInsertedKeys() const override
+        { return true; }
+
+        /*!
+         *  Строка запроса для изменения нескольких записей (PgsqlCommand):
+         *  UPDATE ... FROM (VALUES ...). Параметры первой записи приводятся
+         *  к типам колонок, по ним определяются типы колонок VALUES.
+         */
+        QString updateRows(const DbTable &table,
+                           const DbColumn &keyColumn,
+                           const QVector<DbColumn> &columns,
+                           int rowCount) const override {
+            const QString &tableName = "\"" + table->getModelName() + "\"";
+            const QString &keyName = "\"" + keyColumn->getModelName() + "\"";
+
+            QString queryCommand = "UPDATE " + tableName + " SET ";
+            for (int index = 0; index < columns.count(); ++index) {
+                const QString &columnName =
+                    "\"" + columns[index]->getModelName() + "\"";
+                queryCommand += (index) ? ", " : "";
+                queryCommand += columnName + " = jara_values." + columnName;
+            }
+
+            queryCommand += " FROM (VALUES (?::" +
+                prepareValueType(keyColumn->getModelType());
+            for (const DbColumn &column : columns) {
+                queryCommand += ", ?::" + prepareValueType(column->getModelType());
+            }
+            queryCommand += ")";
+            if (rowCount > 1) {
+                queryCommand += ", " +
+                    prepareRowValues(columns.count() + 1, rowCount - 1);
+            }
+            queryCommand += ") AS jara_values (" + keyName;
+            queryCommand += ", " + prepareColumnNames(columns) + ")";
+            queryCommand += " WHERE " + tableName + "." + keyName;
+            queryCommand += " = jara_values." + keyName;
+            return queryCommand;
+        }
+
+        /*! Тип значения колонки для приведения параметров (PgsqlCommand) */
+        QString prepareValueType(ColumnType type) const {
+            switch (type) {
+                case ColumnType::INT:
+                case ColumnType::INT_NULL:
+                case ColumnType::INT_SERIAL:
+                    return "INT";
+                case ColumnType::BIGINT:
+                case ColumnType::BIGINT_NULL:
+                case ColumnType::BIGINT_SERIAL:
+                    return "BIGINT";
+                default:
+                    return "VARCHAR";
+            }
+        }
+
+        /*! Имя последовательности для блоков ключей таблицы (PgsqlCommand) */
+        QString prepareKeySequence(const DbColumn &keyColumn) const {
+            return "\"" + keyColumn->getTable()->getModelName() + "_" +
+                   keyColumn->getModelName() + "_hilo\"";
+        }
+
+        /*
+         * Шаг последовательности равен размеру блока, поэтому одно
+         * значение nextval резервирует сразу весь блок ключей.
+         * Для существующей последовательности (migrate) следующее значение
+         * сначала переносится за последний выданный блок (по прежнему шагу)
+         * и за MAX(ключ), а затем меняется шаг. Так блоки не пересекаются,
+         * если размер блока изменился, и не выдаются уже занятые ключи,
+         * если последовательность добавлена к таблице с записями.
+         */
+        QString createKeySequence(const DbColumn &keyColumn,
+                                  int blockSize) const override {
+            const QString &sequence = prepareKeySequence(keyColumn);
+            const QString &size = QString::number(blockSize);
+
+            QString queryCommand = "CREATE SEQUENCE IF NOT EXISTS ";
+            queryCommand += sequence + " INCREMENT BY " + size;
+            queryCommand += " START WITH 1; ";
+            queryCommand += "SELECT setval(\'" + sequence + "\', GREATEST(";
+            queryCommand += "(SELECT COALESCE(MAX(\"" + keyColumn->getModelName();
+            queryCommand += "\"), 0) + 1 FROM \"";
+            queryCommand += keyColumn->getTable()->getModelName() + "\"), ";
+            queryCommand += "(SELECT COALESCE(last_value + increment_by, 1) ";
+            queryCommand += "FROM pg_sequences WHERE schemaname = current_schema()";
+            queryCommand += " AND sequencename = \'" +
+                sequence.mid(1, sequence.size() - 2) + "\')), false); ";
+            queryCommand += "ALTER SEQUENCE " + sequence;
+            queryCommand += " INCREMENT BY " + size + "; ";
+            return queryCommand;
+        }
+
+        QVector<QString> reserveKeys(const DbColumn &keyColumn,
+                                     int) const override {
+            QString queryCommand = "SELECT nextval(\'";
+            queryCommand += prepareKeySequence(keyColumn) + "\')";
+            return QVector<QString>() << queryCommand;
+        }
+
+        /*
+         * Драйвер QPSQL получает весь результат запроса до чтения первой
+         * записи, поэтому большие результаты читаются частями через
+         * курсор, объявленный внутри транзакции.
+         */
+        QString declareCursor(const QString &cursor,
+                              const QString &query) const override
+        { return "DECLARE " + cursor + " NO SCROLL CURSOR FOR " + query; }
+
+        QString fetchCursor(const QString &cursor,
+                            int fetchSize) const override {
+            return "FETCH FORWARD " + QString::number(fetchSize) +
+                   " FROM " + cursor;
+        }
+
+        QString closeCursor(const QString &cursor) const override
+        { return "CLOSE " + cursor; }
+
         QString getTableColumns(const QString&,
                                 const DbTable &table) const override {
             QString queryCommand = "SELECT COLUMN_NAME, DATA_TYPE, ";
@@ -17,10 +17,7 @@ namespace jara_lib {
             ColumnTypes[ColumnType::BIGINT] = "BIGINT NOT NULL";
             ColumnTypes[ColumnType::BIGINT_NULL] = "BIGINT NULL";
         }
-        virtual ~IDbCommand() {
-            // Очищаем коллекцию типов
-            ColumnTypes.clear();
-        }
+        virtual ~IDbCommand() {}
 
         /*!
          *  Строка запроса для создания базы данных (IDbCommand);
@@ -301,6 +298,200 @@ namespace jara_lib {
         virtual QString getTableColumn(const QString &dbName,
                                        const DbColumn &column) const = 0;
 
+        /*!
+         *  Строка запроса для вставки нескольких записей в таблицу (IDbCommand);
+         *  {table} - указатель на модель таблицы, в которую вставляются записи;
+         *  {columns} - колонки, значения которых передаются в запрос;
+         *  {rowCount} - количество вставляемых записей;
+         *  {keyColumn} - колонка-счётчик, значения которой нужно вернуть;
+         *  Значения записей передаются через позиционные параметры (?).
+         */
+        virtual QString insertRows(const DbTable &table,
+                                   const QVector<DbColumn> &columns,
+                                   int rowCount,
+                                   const DbColumn& = nullptr) const {
+            // Вносим имя таблицы и перечисляем заполняемые колонки
+            QString queryCommand = "INSERT INTO " + table->getModelName();
+            queryCommand += " (" + prepareColumnNames(columns) + ") ";
+            // Добавляем наборы параметров для каждой записи
+            queryCommand += "VALUES " + prepareRowValues(columns.count(), rowCount);
+
+            return queryCommand;
+        }
+
+        /*!
+         *  Возвращает ли запрос вставки сгенерированные ключи в виде
+         *  набора записей (IDbCommand). Если нет, то ключ первой записи
+         *  берётся через QSqlQuery::lastInsertId, а ключи остальных
+         *  вычисляются с шагом insertKeyIncrement. Для этого СУБД должна
+         *  выдавать ключам записей одного запроса значения подряд (MySQL:
+         *  innodb_autoinc_lock_mode 0 или 1); вставка, в которой записей
+         *  вставлено не столько, сколько передано, отменяется.
+         */
+        virtual bool returnsInsertedKeys() const
+        { return false; }
+
+        /*!
+         *  Запрос шага, с которым СУБД выдаёт значения ключей-счётчиков
+         *  (IDbCommand). Пустая строка - шаг всегда равен 1.
+         */
+        virtual QString insertKeyIncrement() const
+        { return ""; }
+
+        /*!
+         *  Возвращает ли запрос вставки вместе с каждым ключом номер
+         *  записи в запросе (IDbCommand): первая колонка - номер записи,
+         *  вторая - ключ. Нужно, если СУБД не гарантирует порядок ключей.
+         */
+        virtual bool returnsKeyOrdinals() const
+        { return false; }
+
+        /*! Наибольшее количество параметров в одном запросе (IDbCommand) */
+        virtual int maxBoundValues() const
+        { return 65535; }
+
+        /*! Наибольшее количество записей в одном запросе вставки (IDbCommand) */
+        virtual int maxInsertRows() const
+        { return 65535; }
+
+        /*!
+         *  Строка запроса для изменения нескольких записей таблицы (IDbCommand);
+         *  {table} - указатель на модель таблицы, записи которой изменяются;
+         *  {keyColumn} - первичный ключ, по которому находятся записи;
+         *  {columns} - изменяемые колонки;
+         *  {rowCount} - количество изменяемых записей;
+         *  Для каждой записи передаются позиционные параметры (?): значение
+         *  ключа, затем значения колонок в порядке columns. По умолчанию
+         *  записи соединяются с производной таблицей из SELECT ... UNION ALL
+         *  (MySQL не поддерживает UPDATE ... FROM (VALUES ...)).
+         */
+        virtual QString updateRows(const DbTable &table,
+                                   const DbColumn &keyColumn,
+                                   const QVector<DbColumn> &columns,
+                                   int rowCount) const {
+            const QString &tableName = table->getModelName();
+            const QString &keyName = keyColumn->getModelName();
+
+            // Первая запись задаёт имена колонок производной таблицы
+            QString rowValues = "SELECT ? AS " + keyName;
+            QString rowParameters = "?";
+            for (const DbColumn &column : columns) {
+                rowValues += ", ? AS " + column->getModelName();
+                rowParameters += ", ?";
+            }
+            for (int row = 1; row < rowCount; ++row) {
+                rowValues += " UNION ALL SELECT " + rowParameters;
+            }
+
+            QString queryCommand = "UPDATE " + tableName;
+            queryCommand += " INNER JOIN (" + rowValues + ") AS jara_values";
+            queryCommand += " ON " + tableName + "." + keyName;
+            queryCommand += " = jara_values." + keyName + " SET ";
+            for (int index = 0; index < columns.count(); ++index) {
+                const QString &columnName = columns[index]->getModelName();
+                queryCommand += (index) ? ", " : "";
+                queryCommand += tableName + "." + columnName;
+                queryCommand += " = jara_values." + columnName;
+            }
+            return queryCommand;
+        }
+
+        /*!
+         *  Строка запроса для создания хранилища блоков ключей (IDbCommand);
+         *  {keyColumn} - первичный ключ, значения которого выдаёт приложение;
+         *  {blockSize} - количество ключей, резервируемых за один запрос;
+         *  По умолчанию ключи хранятся в общей таблице последовательностей,
+         *  в которой на каждую таблицу приходится одна запись.
+         *  Запрос выполняется и для существующего хранилища (migrate):
+         *  следующий ключ не может быть меньше MAX(ключ) + 1, поэтому
+         *  хранилище, добавленное к таблице с записями, не выдаст уже
+         *  занятые ключи.
+         */
+        virtual QString createKeySequence(const DbColumn &keyColumn,
+                                          int) const {
+            const QString &tableName = keyColumn->getTable()->getModelName();
+
+            QString queryCommand = "CREATE TABLE IF NOT EXISTS ";
+            queryCommand += KeySequenceTable + " (TableName VARCHAR(128) NOT NULL, ";
+            queryCommand += "NextKey BIGINT NOT NULL, PRIMARY KEY (TableName)); ";
+            queryCommand += "INSERT IGNORE INTO " + KeySequenceTable;
+            queryCommand += " (TableName, NextKey) VALUES (\'";
+            queryCommand += tableName + "\', 1); ";
+            queryCommand += "UPDATE " + KeySequenceTable;
+            queryCommand += " SET NextKey = GREATEST(NextKey, (SELECT COALESCE(MAX(";
+            queryCommand += keyColumn->getModelName() + "), 0) + 1 FROM ";
+            queryCommand += tableName + ")) WHERE TableName = \'" + tableName + "\'; ";
+            return queryCommand;
+        }
+
+        /*!
+         *  Запросы для резервирования блока ключей (IDbCommand);
+         *  {keyColumn} - первичный ключ, значения которого выдаёт приложение;
+         *  {blockSize} - количество резервируемых ключей;
+         *  Запросы выполняются по порядку в одном соединении, последний
+         *  из них возвращает первый ключ зарезервированного блока.
+         */
+        virtual QVector<QString> reserveKeys(const DbColumn &keyColumn,
+                                             int blockSize) const {
+            const QString &size = QString::number(blockSize);
+
+            // LAST_INSERT_ID(выражение) запоминает значение в сессии,
+            // поэтому следующий запрос получит границу своего блока
+            QString updateCommand = "UPDATE " + KeySequenceTable;
+            updateCommand += " SET NextKey = LAST_INSERT_ID(NextKey + " + size + ")";
+            updateCommand += " WHERE TableName = \'";
+            updateCommand += keyColumn->getTable()->getModelName() + "\'";
+
+            return QVector<QString>()
+                << updateCommand
+                << "SELECT LAST_INSERT_ID() - " + size;
+        }
+
+        /*!
+         *  Строка запроса для объявления курсора на стороне СУБД (IDbCommand);
+         *  {cursor} - имя курсора;
+         *  {query} - запрос, результат которого читается через курсор;
+         *  Пустая строка означает, что курсоры СУБД не используются,
+         *  и результат читается однонаправленным курсором драйвера.
+         */
+        virtual QString declareCursor(const QString&, const QString&) const
+        { return ""; }
+
+        /*! Строка запроса для чтения следующих записей курсора (IDbCommand) */
+        virtual QString fetchCursor(const QString&, int) const
+        { return ""; }
+
+        /*! Строка запроса для закрытия курсора (IDbCommand) */
+        virtual QString closeCursor(const QString&) const
+        { return ""; }
+
+        /*! Перечисление имён колонок через запятую (IDbCommand) */
+        QString prepareColumnNames(const QVector<DbColumn> &columns) const {
+            QString columnNames = "";
+            for (const DbColumn &column : columns) {
+                if (!columnNames.isEmpty()) {
+                    columnNames += ", ";
+                }
+                columnNames += prepareColumn(column, true).trimmed();
+            }
+            return columnNames;
+        }
+
+        /*! Наборы позиционных параметров для вставляемых записей (IDbCommand) */
+        QString prepareRowValues(int columnCount, int rowCount) const {
+            QString rowValues = "(";
+            for (int column = 0; column < columnCount; ++column) {
+                rowValues += (column) ? ", ?" : "?";
+            }
+            rowValues += ")";
+
+            QString values = rowValues;
+            for (int row = 1; row < rowCount; ++row) {
+                values += ", " + rowValues;
+            }
+            return values;
+        }
+
         virtual QString makeExpressionClause(
             QueryClause clause, const QVector<QString> &columns) const {
             QString expressionPart = "";
@@ -328,8 +519,13 @@ namespace jara_lib {
             return expressionPart;
         }
 
-        static QMap<ColumnType, QString> ColumnTypes;
+        /*
+         * Типы колонок у каждого объекта команд свои: подключения к СУБД
+         * разных типов могут создаваться одновременно в разных потоках.
+         */
+        //! Типы колонок в запросах СУБД (IDbCommand)
+        QMap<ColumnType, QString> ColumnTypes;
+        //! Таблица последовательностей для блоков ключей (IDbCommand)
+        const QString KeySequenceTable = "KeySequences";
     };
-
-    QMap<ColumnType, QString> IDbCommand::ColumnTypes;
 }
@@ -0,0 +1,54 @@
+#include "db_record_cursor.h"
+
+namespace jara_lib {
+    RecordCursor::RecordCursor(DbContext context,
+                               const IExpressionHandler &expression)
+        : _context(context), _fetchSize(expression.getFetchSize()) {
+        if (_fetchSize > 0) {
+            _cursor = _context->openCursor(expression);
+        }
+
+        _records = (_cursor.isEmpty())
+            ? _context->proceedExpression(expression, true)
+            : _context->fetchCursor(_cursor, _fetchSize);
+    }
+
+    RecordCursor::~RecordCursor()
+    { close(); }
+
+    bool RecordCursor::next() {
+        if (_records.next()) {
+            ++_fetched;
+            return true;
+        }
+
+        // Если прочитана неполная часть, то записей в курсоре больше нет
+        if (_cursor.isEmpty() || _fetched < _fetchSize) {
+            close();
+            return false;
+        }
+
+        _records = _context->fetchCursor(_cursor, _fetchSize);
+        _fetched = 0;
+        if (_records.next()) {
+            ++_fetched;
+            return true;
+        }
+
+        close();
+        return false;
+    }
+
+    QVariant RecordCursor::value(int index) const
+    { return _records.value(index); }
+
+    const QSqlQuery& RecordCursor::getQuery() const
+    { return _records; }
+
+    void RecordCursor::close() {
+        if (!_cursor.isEmpty()) {
+            _context->closeCursor(_cursor);
+            _cursor.clear();
+        }
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "db_model_interface.h"
+
+namespace jara_lib {
+    /*!
+     *  Курсор для последовательного чтения записей результата запроса.
+     *  Запрос выполняется при создании курсора, записи читаются только
+     *  вперёд, поэтому драйвер не хранит уже прочитанные записи.
+     *  Если для выражения задан размер выборки (fetchSize), а СУБД
+     *  поддерживает курсоры (PostgreSQL), то записи получаются с сервера
+     *  частями по fetchSize записей, и в памяти клиента находится
+     *  не больше одной такой части.
+     */
+    class RecordCursor {
+    public:
+        /*! Выполнение выражения в заданном контексте (RecordCursor) */
+        RecordCursor(DbContext context,
+                     const IExpressionHandler &expression);
+        /*! Закрытие курсора СУБД, если он не дочитан (RecordCursor) */
+        ~RecordCursor();
+
+        RecordCursor(const RecordCursor&) = delete;
+        RecordCursor& operator=(const RecordCursor&) = delete;
+
+        /*! Переход к следующей записи (RecordCursor) */
+        bool next();
+
+        /*! Значение колонки текущей записи по её номеру (RecordCursor) */
+        QVariant value(int index) const;
+
+        /*! Запрос, из которого читается текущая запись (RecordCursor) */
+        const QSqlQuery& getQuery() const;
+
+    private:
+        /*! Закрытие курсора СУБД (RecordCursor) */
+        void close();
+
+    private:
+        //! Контекст, в котором выполняется запрос (RecordCursor)
+        DbContext _context;
+        //! Количество записей, получаемых за одно обращение (RecordCursor)
+        int _fetchSize;
+        //! Имя курсора СУБД, если результат читается частями (RecordCursor)
+        QString _cursor;
+        //! Количество записей, прочитанных из текущей части (RecordCursor)
+        int _fetched = 0;
+        //! Результат запроса или текущая часть результата (RecordCursor)
+        QSqlQuery _records;
+    };
+};
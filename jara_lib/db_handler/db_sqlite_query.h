@@ -0,0 +1,232 @@
+#pragma once
+
+#include "db_query_interface.h"
+
+namespace jara_lib {
+    /*
+     * База SQLite - это файл (или база в памяти, ":memory:"), который
+     * создаётся при подключении, поэтому отдельной главной базы нет.
+     * Вторичные ключи нельзя добавить к существующей таблице, они
+     * объявляются при создании таблицы. Драйвер QSQLITE выполняет
+     * только одну команду за запрос, поэтому составные запросы делятся
+     * на команды при выполнении (DbConnection::proceedQuery).
+     */
+    class SqliteCommand : public IDbCommand {
+    public:
+        SqliteCommand() {
+            // Колонка INTEGER первичного ключа заполняется SQLite (rowid)
+            ColumnTypes[ColumnType::INT] = "INTEGER NOT NULL";
+            ColumnTypes[ColumnType::INT_NULL] = "INTEGER NULL";
+            ColumnTypes[ColumnType::INT_SERIAL] = "INTEGER NOT NULL";
+            ColumnTypes[ColumnType::BIGINT_SERIAL] = "INTEGER NOT NULL";
+            ColumnTypes[ColumnType::STRING] = "TEXT NOT NULL";
+            ColumnTypes[ColumnType::STRING_NULL] = "TEXT NULL";
+        }
+
+        QString createDatabase(const QString&, bool = false) const override
+        { return ""; }
+
+        QString checkDatabase(const QString&) const override
+        { return "SELECT 1"; }
+
+        QString dropDatabase(const QString&, bool = false) const override
+        { return ""; }
+
+        QString createTable(const QString&, const DbTable &table,
+                            bool existsCheck = false) const override {
+            QString queryCommand = "CREATE TABLE ";
+            queryCommand += (existsCheck) ? "IF NOT EXISTS " : "";
+            queryCommand += table->getModelName() + " (";
+
+            // Добавляем колонки
+            queryCommand += prepareColumns(table->getTableColumns());
+
+            // Добавляем вторичные ключи: позже их не добавить
+            for (const QPair<DbTable, DbColumn> &item :
+                 as_const(table->getFkColumns())) {
+                queryCommand += foreignConstraint(
+                    item.second, item.first->getPkColumn()) + ", ";
+            }
+
+            // Добавляем запрос на создание первичного ключа
+            queryCommand += primaryConstraint(table->getPkColumn());
+
+            queryCommand += "); ";
+            return queryCommand;
+        }
+
+        QString checkTable(const QString&,
+                           const DbTable &table) const override {
+            QString queryCommand = "SELECT COUNT(*) FROM sqlite_master";
+            queryCommand += " WHERE type = \'table\' AND name = \'";
+            queryCommand += table->getModelName() + "\'";
+            return queryCommand;
+        }
+
+        QString dropTable(const QString&, const DbTable &table,
+                          bool existsCheck = false) const override {
+            QString queryCommand = "DROP TABLE ";
+            queryCommand += (existsCheck) ? "IF EXISTS " : "";
+            queryCommand += table->getModelName() + "; ";
+            return queryCommand;
+        }
+
+        QString alterAddColumn(const QString&,
+                               const DbColumn &column,
+                               bool = false) const override {
+            QString queryCommand = "ALTER TABLE ";
+            queryCommand += column->getTable()->getModelName() + " ADD COLUMN ";
+            queryCommand += prepareColumn(column) + "; ";
+            return queryCommand;
+        }
+
+        /*
+         * SQLite не изменяет тип колонки: значения хранятся с типом
+         * самого значения, а не колонки.
+         */
+        QString alterModifyColumn(const QString&, const DbColumn&,
+                                  bool = false) const override
+        { return ""; }
+
+        QString alterDropColumn(const QString&,
+                                const DbColumn &column,
+                                bool = false) const override {
+            QString queryCommand = "ALTER TABLE ";
+            queryCommand += column->getTable()->getModelName() + " DROP COLUMN ";
+            queryCommand += prepareColumn(column, true) + "; ";
+            return queryCommand;
+        }
+
+        QString foreignConstraint(const DbColumn &foreign,
+                                  const DbColumn &primary) const override {
+            QString queryCommand = "CONSTRAINT ";
+            queryCommand +=
+                prepareForeignKey(foreign->getTable(), primary->getTable());
+            queryCommand += " FOREIGN KEY (" + foreign->getModelName();
+            queryCommand += ") REFERENCES ";
+            queryCommand += primary->getTable()->getModelName();
+            queryCommand += "(" + primary->getModelName() + ")";
+            return queryCommand;
+        }
+
+        QString checkForeignKey(const QString&,
+                                const DbTable &fTable,
+                                const DbTable &pTable) const override {
+            QString queryCommand = "SELECT COUNT(*) FROM pragma_foreign_key_list(\'";
+            queryCommand += fTable->getModelName() + "\') WHERE \"table\" = \'";
+            queryCommand += pTable->getModelName() + "\'";
+            return queryCommand;
+        }
+
+        // Вторичные ключи объявляются только при создании таблицы
+        QString alterAddConstraint(const QString&, const DbColumn&,
+                                   const DbColumn&) const override
+        { return ""; }
+
+        QString alterDropConstraint(const QString&, const DbColumn&,
+                                    const DbColumn&) const override
+        { return ""; }
+
+        /*
+         * Ключ вставленной записи берётся через lastInsertId: для запроса
+         * с несколькими записями SQLite возвращает ключ последней из них,
+         * поэтому записи вставляются по одной.
+         */
+        int maxInsertRows() const override
+        { return 1; }
+
+        int maxBoundValues() const override
+        { return 999; }
+
+        /*!
+         *  Строка запроса для изменения нескольких записей (SqliteCommand):
+         *  UPDATE ... FROM (SELECT ... UNION ALL ...), SQLite 3.33 и выше.
+         */
+        QString updateRows(const DbTable &table,
+                           const DbColumn &keyColumn,
+                           const QVector<DbColumn> &columns,
+                           int rowCount) const override {
+            const QString &tableName = table->getModelName();
+            const QString &keyName = keyColumn->getModelName();
+
+            // Первая запись задаёт имена колонок производной таблицы
+            QString rowValues = "SELECT ? AS " + keyName;
+            QString rowParameters = "?";
+            for (const DbColumn &column : columns) {
+                rowValues += ", ? AS " + column->getModelName();
+                rowParameters += ", ?";
+            }
+            for (int row = 1; row < rowCount; ++row) {
+                rowValues += " UNION ALL SELECT " + rowParameters;
+            }
+
+            QString queryCommand = "UPDATE " + tableName + " SET ";
+            for (int index = 0; index < columns.count(); ++index) {
+                const QString &columnName = columns[index]->getModelName();
+                queryCommand += (index) ? ", " : "";
+                queryCommand += columnName + " = jara_values." + columnName;
+            }
+            queryCommand += " FROM (" + rowValues + ") AS jara_values";
+            queryCommand += " WHERE " + tableName + "." + keyName;
+            queryCommand += " = jara_values." + keyName;
+            return queryCommand;
+        }
+
+        QString createKeySequence(const DbColumn &keyColumn,
+                                  int) const override {
+            const QString &tableName = keyColumn->getTable()->getModelName();
+
+            QString queryCommand = "CREATE TABLE IF NOT EXISTS ";
+            queryCommand += KeySequenceTable + " (TableName TEXT NOT NULL, ";
+            queryCommand += "NextKey INTEGER NOT NULL, PRIMARY KEY (TableName)); ";
+            queryCommand += "INSERT OR IGNORE INTO " + KeySequenceTable;
+            queryCommand += " (TableName, NextKey) VALUES (\'";
+            queryCommand += tableName + "\', 1); ";
+            queryCommand += "UPDATE " + KeySequenceTable;
+            queryCommand += " SET NextKey = MAX(NextKey, (SELECT COALESCE(MAX(";
+            queryCommand += keyColumn->getModelName() + "), 0) + 1 FROM ";
+            queryCommand += tableName + ")) WHERE TableName = \'" + tableName + "\'; ";
+            return queryCommand;
+        }
+
+        /*
+         * Запросы выполняются в одной транзакции (ModelContext::generateKey):
+         * после UPDATE другие подключения не пишут в базу до её завершения,
+         * и SELECT читает границу блока, зарезервированного этим UPDATE.
+         */
+        QVector<QString> reserveKeys(const DbColumn &keyColumn,
+                                     int blockSize) const override {
+            const QString &size = QString::number(blockSize);
+            const QString &tableName = keyColumn->getTable()->getModelName();
+
+            QString updateCommand = "UPDATE " + KeySequenceTable;
+            updateCommand += " SET NextKey = NextKey + " + size;
+            updateCommand += " WHERE TableName = \'" + tableName + "\'";
+
+            QString selectCommand = "SELECT NextKey - " + size;
+            selectCommand += " FROM " + KeySequenceTable;
+            selectCommand += " WHERE TableName = \'" + tableName + "\'";
+
+            return QVector<QString>() << updateCommand << selectCommand;
+        }
+
+        QString getTableColumns(const QString&,
+                                const DbTable &table) const override {
+            QString queryCommand = "SELECT name, type, ";
+            queryCommand += "CASE WHEN \"notnull\" THEN \'NO\' ELSE \'YES\' END, ";
+            queryCommand += "NULL, dflt_value FROM pragma_table_info(\'";
+            queryCommand += table->getModelName() + "\')";
+            return queryCommand;
+        }
+
+        QString getTableColumn(const QString&,
+                               const DbColumn &column) const override {
+            QString queryCommand = "SELECT name, type, ";
+            queryCommand += "CASE WHEN \"notnull\" THEN \'NO\' ELSE \'YES\' END, ";
+            queryCommand += "dflt_value FROM pragma_table_info(\'";
+            queryCommand += column->getTable()->getModelName() + "\') ";
+            queryCommand += "WHERE name = \'" + column->getModelName() + "\'";
+            return queryCommand;
+        }
+    };
+};
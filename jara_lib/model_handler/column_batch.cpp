@@ -0,0 +1,78 @@
+#include "column_batch.h"
+#include "db_handler/db_record_cursor.h"
+
+namespace jara_lib {
+    ColumnBatch::ColumnBatch(const QVector<ColumnInfo> &columns) {
+        _columns.reserve(columns.count());
+        for (const ColumnInfo &info : columns) {
+            Column column;
+            column.name = info.columnName;
+            column.type = info.columnType;
+            if (column.type >= ColumnType::STRING) {
+                column.offsets.append(0);
+            }
+            _columns.append(column);
+        }
+    }
+
+    int ColumnBatch::columnIndex(const QString &name) const {
+        for (int index = 0; index < _columns.count(); ++index) {
+            if (_columns[index].name == name) {
+                return index;
+            }
+        }
+        return -1;
+    }
+
+    void ColumnBatch::reserve(int rowCount) {
+        for (Column &column : _columns) {
+            column.nulls.reserve((rowCount + 7) / 8);
+            switch (column.type) {
+                case ColumnType::INT:
+                case ColumnType::INT_NULL:
+                case ColumnType::INT_SERIAL:
+                    column.ints.reserve(rowCount);
+                    break;
+                case ColumnType::BIGINT:
+                case ColumnType::BIGINT_NULL:
+                case ColumnType::BIGINT_SERIAL:
+                    column.bigInts.reserve(rowCount);
+                    break;
+                default:
+                    column.offsets.reserve(rowCount + 1);
+            }
+        }
+    }
+
+    void ColumnBatch::append(const RecordCursor &records) {
+        const int row = _rowCount++;
+
+        for (int index = 0; index < _columns.count(); ++index) {
+            Column &column = _columns[index];
+            const QVariant &value = records.value(index);
+
+            if ((row & 7) == 0) {
+                column.nulls.append(0);
+            }
+            if (value.isNull()) {
+                column.nulls.last() |= quint8(1 << (row & 7));
+            }
+
+            switch (column.type) {
+                case ColumnType::INT:
+                case ColumnType::INT_NULL:
+                case ColumnType::INT_SERIAL:
+                    column.ints.append(value.toInt());
+                    break;
+                case ColumnType::BIGINT:
+                case ColumnType::BIGINT_NULL:
+                case ColumnType::BIGINT_SERIAL:
+                    column.bigInts.append(value.toLongLong());
+                    break;
+                default:
+                    column.bytes.append(value.toString().toUtf8());
+                    column.offsets.append(column.bytes.size());
+            }
+        }
+    }
+};
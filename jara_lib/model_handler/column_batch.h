@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QByteArray>
+#include "db_handler/db_model_interface.h"
+
+namespace jara_lib {
+    class RecordCursor;
+
+    /*!
+     *  Результат запроса, разложенный по колонкам (struct-of-arrays).
+     *  Для каждой выбранной колонки хранится один непрерывный вектор
+     *  значений её типа: int32 для INT, int64 для BIGINT, для строк -
+     *  смещения и общий буфер байт в UTF-8. Отсутствующие значения
+     *  отмечаются в битовой карте (бит установлен - значение NULL),
+     *  а в векторе значений на их месте хранится ноль.
+     *  Циклы агрегации идут по непрерывной памяти одного типа и не
+     *  обращаются ни к QVariant, ни к виртуальным методам колонок.
+     */
+    class ColumnBatch {
+    public:
+        /*! Значения одной колонки результата (ColumnBatch) */
+        struct Column {
+            QString name;
+            ColumnType type;
+
+            //! Значения колонок INT
+            QVector<qint32> ints;
+            //! Значения колонок BIGINT
+            QVector<qint64> bigInts;
+            //! Смещения строк в буфере: строка N - [offsets[N], offsets[N+1])
+            QVector<qint32> offsets;
+            //! Байты всех строк колонки подряд (UTF-8)
+            QByteArray bytes;
+            //! Битовая карта отсутствующих значений, по биту на запись
+            QVector<quint8> nulls;
+
+            bool isNull(int row) const
+            { return nulls[row >> 3] & (1 << (row & 7)); }
+
+            /*! Строковое значение записи (только для колонок STRING) */
+            QString string(int row) const {
+                return QString::fromUtf8(bytes.constData() + offsets[row],
+                                         offsets[row + 1] - offsets[row]);
+            }
+        };
+
+    public:
+        /*! Колонки результата по порядку выбора (ColumnBatch) */
+        explicit ColumnBatch(const QVector<ColumnInfo> &columns = {});
+
+        int rowCount() const
+        { return _rowCount; }
+
+        int columnCount() const
+        { return _columns.count(); }
+
+        const Column& column(int index) const
+        { return _columns[index]; }
+
+        /*! Номер колонки по имени, -1 если колонка не выбрана */
+        int columnIndex(const QString &name) const;
+
+        /*! Резервирование памяти под заданное число записей */
+        void reserve(int rowCount);
+
+        /*! Добавление текущей записи курсора в колонки (ColumnBatch) */
+        void append(const RecordCursor &records);
+
+    private:
+        QVector<Column> _columns;
+        int _rowCount = 0;
+    };
+};
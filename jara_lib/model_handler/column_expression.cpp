@@ -1,4 +1,5 @@
 #include "column_expression.h"
+#include "table_model.h"
 
 namespace jara_lib {
     COL::COL(DbColumn columnNode) :
@@ -77,6 +78,102 @@ namespace jara_lib {
         return concatenated_expression;
     }
 
+    /* Список значений для IN в виде строки запроса */
+    static QString prepareValueList(const QVector<QVariant> &values) {
+        QString valueList = "";
+        for (const QVariant &value : values) {
+            if (!valueList.isEmpty()) {
+                valueList += ", ";
+            }
+            valueList += ExpressionNode::ExpressionVariant(value);
+        }
+        return "(" + valueList + ")";
+    }
+
+    /*
+     * Условие с постоянным значением для пустого списка IN: "IN ()"
+     * не допускается синтаксисом SQL. Пустой список не содержит ни
+     * одного значения, поэтому IN ложно, а NOT IN истинно.
+     */
+    static QSharedPointer<ExpressionNode> constantCondition(bool value) {
+        return QSharedPointer<ExpressionNode>::create(
+            ExpressionNode::ExpressionVariant::fromQuery("1"),
+            ExpressionNode::ExpressionVariant::fromQuery((value) ? "1" : "0"),
+            ColumnOperator::EQUAL);
+    }
+
+    COL& COL::in(ExpressionHandler &query) {
+        QSharedPointer<COL> column =
+            QSharedPointer<COL>::create(*this);
+        _expression = QSharedPointer<ExpressionNode>::create(
+            column, ExpressionNode::ExpressionVariant::fromQuery(
+                "(" + query.toSubquery() + ")"), ColumnOperator::IN);
+        return *this;
+    }
+
+    COL& COL::in(const QVector<QVariant> &values) {
+        if (values.isEmpty()) {
+            _expression = constantCondition(false);
+            return *this;
+        }
+
+        QSharedPointer<COL> column =
+            QSharedPointer<COL>::create(*this);
+        _expression = QSharedPointer<ExpressionNode>::create(
+            column, ExpressionNode::ExpressionVariant::fromQuery(
+                prepareValueList(values)), ColumnOperator::IN);
+        return *this;
+    }
+
+    COL& COL::notIn(ExpressionHandler &query) {
+        QSharedPointer<COL> column =
+            QSharedPointer<COL>::create(*this);
+        _expression = QSharedPointer<ExpressionNode>::create(
+            column, ExpressionNode::ExpressionVariant::fromQuery(
+                "(" + query.toSubquery() + ")"), ColumnOperator::NOTIN);
+        return *this;
+    }
+
+    COL& COL::notIn(const QVector<QVariant> &values) {
+        if (values.isEmpty()) {
+            _expression = constantCondition(true);
+            return *this;
+        }
+
+        QSharedPointer<COL> column =
+            QSharedPointer<COL>::create(*this);
+        _expression = QSharedPointer<ExpressionNode>::create(
+            column, ExpressionNode::ExpressionVariant::fromQuery(
+                prepareValueList(values)), ColumnOperator::NOTIN);
+        return *this;
+    }
+
+    COL exists(ExpressionHandler &query) {
+        COL exists_expression;
+
+        exists_expression._expression =
+            QSharedPointer<ExpressionNode>::create(
+                ExpressionNode::ExpressionVariant(),
+                ExpressionNode::ExpressionVariant::fromQuery(
+                    "(" + query.toSubquery() + ")"),
+                ColumnOperator::EXISTS);
+
+        return exists_expression;
+    }
+
+    COL notExists(ExpressionHandler &query) {
+        COL exists_expression;
+
+        exists_expression._expression =
+            QSharedPointer<ExpressionNode>::create(
+                ExpressionNode::ExpressionVariant(),
+                ExpressionNode::ExpressionVariant::fromQuery(
+                    "(" + query.toSubquery() + ")"),
+                ColumnOperator::NOTEXISTS);
+
+        return exists_expression;
+    }
+
     const QSharedPointer<ExpressionNode>& COL::getExpression() const
     { return _expression; }
 
@@ -93,11 +190,21 @@ namespace jara_lib {
         const QSharedPointer<ExpressionNode> &node)
         : ExpressionVariant(nullptr, QVariant(), node) {}
 
+    ExpressionNode::ExpressionVariant
+    ExpressionNode::ExpressionVariant::fromQuery(const QString &query) {
+        ExpressionVariant variant;
+        variant._query = query;
+        return variant;
+    }
+
     ExpressionNode::ExpressionVariant::operator QString() const {
+        if (!_query.isEmpty()) {
+            return _query;
+        }
         return (_column)
             ? _column.data()->operator QString()
             : (_value.userType() == QMetaType::QString)
-                ? "\'" + _value.toString() + "\'"
+                ? "\'" + _value.toString().replace("\'", "\'\'") + "\'"
                 : _value.toString();
     }
 
@@ -112,7 +219,9 @@ namespace jara_lib {
 
 
     ExpressionNode::operator QString() const {
-        return _first + " " +
+        // У EXISTS нет левой части выражения
+        const QString &first = _first;
+        return ((first.isEmpty()) ? "" : first + " ") +
              _column_operators_[_operator] + " " +
              _second;
     }
@@ -129,6 +238,96 @@ namespace jara_lib {
         { _expression_nodes_[QueryClause::FROM].append(tableName); }
     }
 
+    ExpressionHandler ExpressionHandler::subquery() const {
+        ExpressionHandler handler;
+        handler._table = _table;
+        handler._expression_nodes_[QueryClause::FROM] =
+            _expression_nodes_.value(QueryClause::FROM);
+        return handler;
+    }
+
+    QString ExpressionHandler::toSubquery() {
+        if (_expression_nodes_[QueryClause::SELECT].isEmpty()) {
+            _expression_nodes_[QueryClause::SELECT].append("1");
+        }
+
+        const QString &subquery =
+            _table->getTableContext()->prepareExpression(*this);
+        clearExpression();
+        return subquery;
+    }
+
+    void ExpressionHandler::clearExpression() {
+        const QVector<QString> from = _expression_nodes_[QueryClause::FROM];
+        _expression_nodes_.clear();
+        _expression_nodes_[QueryClause::FROM] = from;
+        _select_columns_.clear();
+        _fetch_size_ = 0;
+        _parallel_block_ = 0;
+        _intern_strings_ = false;
+        _string_pool_.reset();
+        _joined_tables_.clear();
+        _included_tables_.clear();
+    }
+
+    ColumnBatch ExpressionHandler::toColumns() {
+        // Колонки идут в порядке объявления: номер колонки в наборе
+        // не зависит от порядка обхода множества колонок
+        if (_select_columns_.isEmpty()) {
+            const TableModel *table = static_cast<const TableModel*>(_table);
+            for (int ordinal = 0; ordinal < table->getColumnCount(); ++ordinal) {
+                const DbColumn column = table->getColumn(ordinal);
+                if (!column->isDeferred()) {
+                    select(COL(column));
+                }
+            }
+        }
+
+        // Тип вектора значений определяется типом колонки модели,
+        // вычисляемые выражения хранятся как строки
+        QVector<ColumnInfo> columns;
+        const QVector<QString> &nodes =
+            _expression_nodes_.value(QueryClause::SELECT);
+        for (int index = 0; index < _select_columns_.count(); ++index) {
+            DbColumn column = _select_columns_[index];
+
+            ColumnInfo columnInfo;
+            columnInfo.columnName = (column)
+                ? column->getModelName() : nodes[index];
+            columnInfo.columnType = (column)
+                ? column->getModelType() : ColumnType::STRING_NULL;
+            columns.append(columnInfo);
+        }
+
+        ColumnBatch batch(columns);
+        RecordCursor records(_table->getTableContext(), *this);
+        clearExpression();
+
+        if (records.getQuery().size() > 0) {
+            batch.reserve(records.getQuery().size());
+        }
+        while (records.next()) {
+            batch.append(records);
+        }
+
+        return batch;
+    }
+
+    void ExpressionHandler::checkProjection(int fieldCount) {
+        const int columnCount =
+            _expression_nodes_.value(QueryClause::SELECT).count();
+        if (columnCount == fieldCount) {
+            return;
+        }
+
+        clearExpression();
+        if (!columnCount) {
+            throw QString("Columns for the projection are not selected");
+        }
+        throw "The projection expects " + QString::number(fieldCount) +
+              " columns, selected " + QString::number(columnCount);
+    }
+
     QVector<QString> ExpressionHandler::parseExpression(
             const QSharedPointer<ExpressionNode> &node) const {
         QVector<QString> expressions;
@@ -1,14 +1,23 @@
 #pragma once
 
-#include <cxxabi.h>
 #include <memory>
+#include <tuple>
+#include <iterator>
+#include <functional>
 #include <QStack>
 #include <QDebug>
 #include <QSharedPointer>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include "db_handler/db_model_interface.h"
+#include "db_handler/db_record_cursor.h"
+#include "column_batch.h"
+#include "row_set.h"
 
 namespace jara_lib {
     class ExpressionNode;
+    class ExpressionHandler;
+    template <class Table> class QueryStream;
 
     class COL {
     public:
@@ -25,8 +34,23 @@ namespace jara_lib {
         COL operator&&(const COL&) const;
         COL operator||(const COL&) const;
 
+        /*
+         * Проверка вхождения значения колонки в результат подзапроса
+         * или в список значений. Подзапрос выполняется на стороне СУБД,
+         * поэтому фильтрация по связанной таблице не требует ни
+         * отдельного запроса, ни join с повторением записей.
+         * Пустой список значений даёт условие с постоянным значением.
+         */
+        COL& in(ExpressionHandler&);
+        COL& in(const QVector<QVariant>&);
+        COL& notIn(ExpressionHandler&);
+        COL& notIn(const QVector<QVariant>&);
+
         const QSharedPointer<ExpressionNode>& getExpression() const;
 
+        friend COL exists(ExpressionHandler&);
+        friend COL notExists(ExpressionHandler&);
+
     private:
         DbColumn _column;
         QSharedPointer<ExpressionNode> _expression;
@@ -41,11 +65,15 @@ namespace jara_lib {
             ExpressionVariant(const QVariant&);
             ExpressionVariant(const QSharedPointer<ExpressionNode>&);
 
+            //! Готовая часть запроса: подзапрос или список значений
+            static ExpressionVariant fromQuery(const QString&);
+
             operator QString() const;
 
             QSharedPointer<COL> _column;
             QVariant _value;
             QSharedPointer<ExpressionNode> _node;
+            QString _query;
         };
 
     public:
@@ -61,99 +89,934 @@ namespace jara_lib {
         ColumnOperator _operator;
     };
 
+    /*
+     * Чтение значений текущей записи в элементы кортежа: элемент
+     * с индексом N получает значение N-й выбранной колонки.
+     */
+    template <std::size_t Size, class Tuple>
+    struct TupleReader {
+        static void read(const RecordCursor &records, Tuple &row) {
+            TupleReader<Size - 1, Tuple>::read(records, row);
+            using Element = typename std::tuple_element<Size - 1, Tuple>::type;
+            std::get<Size - 1>(row) = records.value(Size - 1).template value<Element>();
+        }
+    };
+
+    template <class Tuple>
+    struct TupleReader<0, Tuple> {
+        static void read(const RecordCursor&, Tuple&) {}
+    };
+
+    /*!
+     *  Таблица строк одного запроса: равные значения строковых колонок
+     *  заменяются одним и тем же объектом QString (неявное разделение
+     *  данных), поэтому повторяющиеся значения хранятся в памяти один раз.
+     *  Блокировка нужна для конвейерного чтения (parallel). Значений мало,
+     *  поэтому почти все обращения - поиск под блокировкой для чтения,
+     *  которую потоки берут одновременно.
+     */
+    class StringPool {
+    public:
+        QString intern(const QString &value) {
+            {
+                QReadLocker locker(&_lock);
+                QSet<QString>::const_iterator found = _strings.constFind(value);
+                if (found != _strings.constEnd()) {
+                    return *found;
+                }
+            }
+
+            QWriteLocker locker(&_lock);
+            QSet<QString>::const_iterator found = _strings.constFind(value);
+            if (found != _strings.constEnd()) {
+                return *found;
+            }
+            _strings.insert(value);
+            return value;
+        }
+
+    private:
+        QSet<QString> _strings;
+        QReadWriteLock _lock;
+    };
+
+    /*
+     * Шаг заполнения объекта таблицы: колонка результата с номером index
+     * записывается в колонку таблицы с номером ordinal функцией decode
+     * типа этой колонки. План из таких шагов строится один раз на запрос.
+     * Значения строковых колонок, для которых задана таблица строк
+     * (strings), перед записью заменяются значениями из этой таблицы.
+     * Шаг с index -1 отмечает отложенную колонку, не выбранную в запросе,
+     * как не загруженную: её значение загружается при обращении.
+     */
+    struct DecodeStep {
+        int index;
+        int ordinal;
+        ColumnDecoder decode;
+        QSharedPointer<StringPool> strings;
+    };
+    using DecodePlan = QVector<DecodeStep>;
+
     class ExpressionHandler : public IExpressionHandler {
     protected:
         void setQueryTable(const DbTable&) override;
 
+    public:
+        DbTable getQueryTable() const override
+        { return _table; }
+
+        /*!
+         *  Отдельное выражение по той же таблице для подзапроса: узлы
+         *  подзапроса не смешиваются с узлами запроса, который строится
+         *  на этой таблице, и не сбрасывают их. Нужно, когда подзапрос
+         *  обращается к той же таблице, что и внешний запрос:
+         *  employees.where(COL(employees.Id).in(employees.subquery()
+         *      .select(COL(employees.ManagerId))))
+         */
+        ExpressionHandler subquery() const;
+
+        /*!
+         *  Строка выражения для использования в качестве подзапроса.
+         *  Узлы выражения после этого сбрасываются, чтобы таблицу
+         *  контекста можно было использовать для следующих запросов.
+         *  Если колонки не выбраны, подзапрос выбирает константу
+         *  (для EXISTS важно только наличие записей).
+         */
+        QString toSubquery();
+
+        /*! Сброс всех узлов выражения, кроме имени таблицы (FROM) */
+        void clearExpression();
+
+        int getFetchSize() const override
+        { return _fetch_size_; }
+
     private:
+        /*
+         * В качестве образца для запроса используется таблица контекста,
+         * от имени которой строится выражение. Первичный ключ всегда
+         * выбирается первым. Если колонки не выбраны, то выбираются все
+         * колонки таблицы, кроме отложенных (Deferred), в порядке
+         * объявления: список выбора одинаков для всех запусков программы.
+         */
         template <class Table>
-        QSharedPointer<Table> objectPrepare() {
-            QSharedPointer<Table> object =
-                QSharedPointer<Table>::create(*(static_cast<Table*>(this)));
+        const Table& objectPrepare() {
+            const Table &table = *static_cast<Table*>(this);
 
-            DbColumn primaryKey = object->getPkColumn();
+            DbColumn primaryKey = table.getPkColumn();
+            if (_expression_nodes_.value(QueryClause::SELECT).isEmpty()) {
+                for (int ordinal = 0; ordinal < table.getColumnCount(); ++ordinal) {
+                    const DbColumn column = table.getColumn(ordinal);
+                    if (column != primaryKey && !column->isDeferred()) {
+                        select(COL(column));
+                    }
+                }
+            }
 
             _expression_nodes_[QueryClause::SELECT].insert(0, COL(primaryKey));
-            return object;
+            _select_columns_.insert(0, primaryKey);
+            return table;
+        }
+
+        /*
+         * Сопоставление выбранных колонок с колонками таблицы выполняется
+         * один раз на запрос: для каждой колонки результата запоминается
+         * порядковый номер колонки таблицы и функция записи значения
+         * для её типа. Колонки других таблиц в план не попадают.
+         * Номер колонки результата совпадает с её позицией в списке
+         * выбора, поэтому поиск по QSqlRecord не нужен.
+         * Строковые колонки с признаком Interned, колонки присоединённых
+         * таблиц (internAll) и все строковые колонки запроса с intern()
+         * заполняются через общую для запроса таблицу строк.
+         */
+        template <class Table>
+        DecodePlan prepareDecodePlan(const Table &table,
+                                     bool internAll = false) const {
+            const QVector<QString> &nodes =
+                _expression_nodes_.value(QueryClause::SELECT);
+
+            DecodePlan plan;
+            plan.reserve(nodes.count());
+            QVector<bool> selected(table.getColumnCount(), false);
+            for (int index = 0; index < nodes.count(); ++index) {
+                const int ordinal = table.getColumnOrdinal(nodes[index]);
+                if (ordinal < 0) {
+                    continue;
+                }
+                selected[ordinal] = true;
+
+                const DbColumn column = table.getColumn(ordinal);
+                QSharedPointer<StringPool> strings;
+                if ((column->getModelType() == ColumnType::STRING ||
+                     column->getModelType() == ColumnType::STRING_NULL) &&
+                    (internAll || _intern_strings_ || column->isInterned())) {
+                    if (!_string_pool_) {
+                        _string_pool_ = QSharedPointer<StringPool>::create();
+                    }
+                    strings = _string_pool_;
+                }
+                plan.append({ index, ordinal, column->getDecoder(), strings });
+            }
+
+            for (int ordinal = 0; ordinal < table.getColumnCount(); ++ordinal) {
+                if (!selected[ordinal] && table.getColumn(ordinal)->isDeferred()) {
+                    plan.append({ -1, ordinal, nullptr, nullptr });
+                }
+            }
+            return plan;
+        }
+
+        /*
+         * Заполнение колонок объекта значениями текущей записи: записи
+         * курсора или записи, скопированной из курсора (QVector<QVariant>).
+         * Функция конкретизируется для типа таблицы, а значения пишутся
+         * функциями плана, поэтому на колонку нет ни одного виртуального
+         * вызова.
+         */
+        template <class Table, class Record>
+        static void hydrate(Table &tableObj, const Record &records,
+                            const DecodePlan &plan) {
+            for (const DecodeStep &step : plan) {
+                if (step.index < 0) {
+                    tableObj.getColumn(step.ordinal)->setLoaded(false);
+                }
+                else if (step.strings) {
+                    const QVariant &value = records.value(step.index);
+                    step.decode(tableObj.getColumn(step.ordinal),
+                        (value.isNull()) ? value
+                            : QVariant(step.strings->intern(value.toString())));
+                }
+                else {
+                    step.decode(tableObj.getColumn(step.ordinal),
+                                records.value(step.index));
+                }
+            }
+        }
+
+        template <class Table> friend class QueryStream;
+
+        /*
+         * Присоединённая таблица, объекты которой заполняются вместе
+         * с объектами таблицы запроса. Ссылающаяся колонка - вторичный
+         * ключ таблицы запроса или другой присоединённой таблицы.
+         * Функции создания и заполнения объектов конкретизируются
+         * для типа присоединённой таблицы в join.
+         */
+        struct JoinedTable {
+            QString tableName;
+            QString referenceTable;
+            QString referenceColumn;
+            std::function<QSharedPointer<ITableModel>(DbContext)> create;
+            std::function<DecodePlan(const ExpressionHandler&,
+                                     const ITableModel&)> preparePlan;
+            std::function<void(ITableModel&, const RecordCursor&,
+                               const DecodePlan&)> hydrate;
+        };
+
+        /* Состояние заполнения присоединённой таблицы на время запроса */
+        struct JoinPlan {
+            JoinedTable joined;
+            DecodePlan plan;
+            // Номер колонки первичного ключа в результате запроса
+            int keyIndex;
+            // Номер ссылающейся колонки в таблице запроса (-1 - колонка
+            // другой присоединённой таблицы)
+            int referenceOrdinal;
+            // Номер плана присоединённой таблицы со ссылающейся колонкой
+            // (-1 - ссылается таблица запроса)
+            int referencePlan;
+            // Созданные объекты по значению первичного ключа
+            QHash<qlonglong, QSharedPointer<ITableModel>> rows;
+        };
+        using JoinPlans = QVector<JoinPlan>;
+
+        /*
+         * Таблица, записи которой загружаются после запроса по значениям
+         * вторичного ключа таблицы запроса (include). Функция загрузки
+         * конкретизируется для типа таблицы в include.
+         */
+        struct IncludedTable {
+            QString tableName;
+            std::function<void(DbContext, const QVector<DbColumn>&)> load;
+        };
+
+        /* Вторичный ключ таблицы запроса для загрузки записей include */
+        struct IncludePlan {
+            IncludedTable included;
+            int keyOrdinal;
+        };
+        using IncludePlans = QVector<IncludePlan>;
+
+        /*
+         * Подготовка загрузки записей include: вторичный ключ, который
+         * ссылается на таблицу include, добавляется в список выбора,
+         * если он не выбран.
+         */
+        template <class Table>
+        IncludePlans prepareIncludes(const Table &table) {
+            IncludePlans includePlans;
+            for (const IncludedTable &included : _included_tables_) {
+                for (const QPair<DbTable, DbColumn> &foreignKey :
+                     table.getFkColumns()) {
+                    if (foreignKey.first->getModelName() !=
+                        included.tableName) {
+                        continue;
+                    }
+
+                    const QString &keyNode = COL(foreignKey.second);
+                    QVector<QString> &nodes =
+                        _expression_nodes_[QueryClause::SELECT];
+                    if (!nodes.contains(keyNode)) {
+                        nodes.append(keyNode);
+                        _select_columns_.append(foreignKey.second);
+                    }
+
+                    includePlans.append({ included, table.getColumnOrdinal(
+                        foreignKey.second->getModelName()) });
+                }
+            }
+            return includePlans;
+        }
+
+        /*
+         * Сбор значений вторичных ключей, выбранных в запросе, для всех
+         * записей результата. Группа значений разделяется колонками ключа
+         * всех записей: ForeignKey::load() на любой из записей загружает
+         * связанные записи сразу для всего результата одним запросом.
+         */
+        template <class Table>
+        static void groupReferences(QVector<Table> &tables,
+                                    const DecodePlan &plan) {
+            if (tables.isEmpty()) {
+                return;
+            }
+
+            // Отложенные колонки, которые не выбраны в запросе,
+            // загружаются по значениям первичного ключа
+            QSharedPointer<ReferenceGroup> keyGroup;
+            for (const DbColumn column : tables.first().getTableColumns()) {
+                if (!column->isDeferred() || column->isLoaded()) {
+                    continue;
+                }
+
+                if (!keyGroup) {
+                    keyGroup = QSharedPointer<ReferenceGroup>::create();
+                    for (Table &tableObj : tables) {
+                        keyGroup->keys.append(
+                            tableObj.getPkColumn()->getModelValue());
+                    }
+                }
+
+                const int ordinal =
+                    tables.first().getColumnOrdinal(column->getModelName());
+                // Каждой колонке - своя группа с общими ключами
+                QSharedPointer<ReferenceGroup> referenceGroup =
+                    QSharedPointer<ReferenceGroup>::create();
+                referenceGroup->keys = keyGroup->keys;
+                for (Table &tableObj : tables) {
+                    tableObj.getColumn(ordinal)->
+                        setReferenceGroup(referenceGroup);
+                }
+            }
+
+            for (const DecodeStep &step : plan) {
+                if (tables.first().getColumn(step.ordinal)->
+                        getModelCellType() != FieldType::FOREIGN_KEY) {
+                    continue;
+                }
+
+                QSharedPointer<ReferenceGroup> referenceGroup =
+                    QSharedPointer<ReferenceGroup>::create();
+                QSet<qlonglong> distinct;
+                for (Table &tableObj : tables) {
+                    const DbColumn key = tableObj.getColumn(step.ordinal);
+                    // Ключ NULL не ссылается на запись и в запрос не входит
+                    const QVariant &value = key->getModelValue();
+                    if (!key->isNull() &&
+                        !distinct.contains(value.toLongLong())) {
+                        distinct.insert(value.toLongLong());
+                        referenceGroup->keys.append(value);
+                    }
+                    key->setReferenceGroup(referenceGroup);
+                }
+            }
+        }
+
+        /* Загрузка записей include и связывание их с записями запроса */
+        template <class Table>
+        static void loadIncludes(QVector<Table> &tables,
+                                 const IncludePlans &includePlans) {
+            if (tables.isEmpty()) {
+                return;
+            }
+
+            for (const IncludePlan &includePlan : includePlans) {
+                QVector<DbColumn> keys;
+                keys.reserve(tables.count());
+                for (Table &tableObj : tables) {
+                    keys.append(tableObj.getColumn(includePlan.keyOrdinal));
+                }
+                includePlan.included.load(
+                    tables.first().getTableContext(), keys);
+            }
+        }
+
+        template <class Table>
+        void registerJoin(const QString &tableName, const COL &joinColumn) {
+            const QSharedPointer<ExpressionNode> &node =
+                joinColumn.getExpression();
+            if (!node || !node->_first._column || !node->_second._column) {
+                return;
+            }
+
+            DbColumn first = node->_first._column->getColumn();
+            DbColumn second = node->_second._column->getColumn();
+            if (first->getTable()->getModelName() == tableName) {
+                std::swap(first, second);
+            }
+
+            // Объекты заполняются только для связи "многие к одному"
+            if (second->getTable()->getModelName() != tableName ||
+                second->getModelCellType() != FieldType::PRIMARY_KEY ||
+                first->getModelCellType() != FieldType::FOREIGN_KEY) {
+                return;
+            }
+
+            JoinedTable joined;
+            joined.tableName = tableName;
+            joined.referenceTable = first->getTable()->getModelName();
+            joined.referenceColumn = first->getModelName();
+            joined.create = [](DbContext context) {
+                QSharedPointer<Table> row = QSharedPointer<Table>::create(
+                    Table::typeName(), nullptr);
+                row->registerContext(context);
+                return QSharedPointer<ITableModel>(row);
+            };
+            joined.preparePlan = [](const ExpressionHandler &expression,
+                                    const ITableModel &prototype) {
+                return expression.prepareDecodePlan(
+                    static_cast<const Table&>(prototype), true);
+            };
+            joined.hydrate = [](ITableModel &row, const RecordCursor &records,
+                                const DecodePlan &plan) {
+                ExpressionHandler::hydrate(static_cast<Table&>(row),
+                                           records, plan);
+            };
+            _joined_tables_.append(joined);
+        }
+
+        /*
+         * Подготовка заполнения присоединённых таблиц: первичный ключ
+         * каждой из них добавляется в список выбора, если он не выбран,
+         * и строится план заполнения её колонок.
+         */
+        template <class Table>
+        JoinPlans prepareJoins(const Table &table) {
+            JoinPlans joinPlans;
+            for (const JoinedTable &joined : _joined_tables_) {
+                const QSharedPointer<ITableModel> &prototype =
+                    joined.create(table.getTableContext());
+
+                const QString &keyNode = COL(prototype->getPkColumn());
+                QVector<QString> &nodes =
+                    _expression_nodes_[QueryClause::SELECT];
+                int keyIndex = nodes.indexOf(keyNode);
+                if (keyIndex < 0) {
+                    keyIndex = nodes.count();
+                    nodes.append(keyNode);
+                    _select_columns_.append(nullptr);
+                }
+
+                JoinPlan joinPlan;
+                joinPlan.joined = joined;
+                joinPlan.plan = joined.preparePlan(*this, *prototype);
+                joinPlan.keyIndex = keyIndex;
+                joinPlan.referenceOrdinal =
+                    (joined.referenceTable == table.getModelName())
+                    ? table.getColumnOrdinal(joined.referenceColumn) : -1;
+                // Ссылающаяся таблица - последняя присоединённая до этой
+                // таблица с таким именем
+                joinPlan.referencePlan = -1;
+                if (joinPlan.referenceOrdinal < 0) {
+                    for (int index = joinPlans.count() - 1; index >= 0;
+                         --index) {
+                        if (joinPlans[index].joined.tableName ==
+                            joined.referenceTable) {
+                            joinPlan.referencePlan = index;
+                            break;
+                        }
+                    }
+                }
+                joinPlans.append(joinPlan);
+            }
+            return joinPlans;
+        }
+
+        /*
+         * Заполнение присоединённых объектов текущей записи и связывание
+         * их с объектом таблицы запроса. Объект присоединённой таблицы
+         * создаётся только при первой встрече значения её первичного
+         * ключа, тогда же он связывается со своими родительскими объектами.
+         * Родительский объект из карты записей контекста связывается,
+         * если у его ключа ещё нет связанной записи.
+         * Объекты текущей записи хранятся по номеру плана, а не по имени
+         * таблицы: несколько присоединений одной таблицы не заменяют
+         * объекты друг друга.
+         */
+        template <class Table>
+        static void hydrateJoins(Table &tableObj, const RecordCursor &records,
+                                 JoinPlans &joinPlans) {
+            if (joinPlans.isEmpty()) {
+                return;
+            }
+
+            QVector<bool> created(joinPlans.count(), false);
+            QVector<QSharedPointer<ITableModel>> current(joinPlans.count());
+            for (int index = 0; index < joinPlans.count(); ++index) {
+                JoinPlan &joinPlan = joinPlans[index];
+                const QVariant &key = records.value(joinPlan.keyIndex);
+                if (key.isNull()) {
+                    continue;
+                }
+
+                QSharedPointer<ITableModel> &row =
+                    joinPlan.rows[key.toLongLong()];
+                // Запись, уже загруженная в контекст целиком, берётся
+                // из карты записей контекста и не заполняется повторно
+                if (!row && tableObj.getTableContext()) {
+                    row = tableObj.getTableContext()->findRow(
+                        joinPlan.joined.tableName, key.toLongLong());
+                }
+                if (!row) {
+                    row = joinPlan.joined.create(tableObj.getTableContext());
+                    joinPlan.joined.hydrate(*row, records, joinPlan.plan);
+                    created[index] = true;
+                }
+                current[index] = row;
+            }
+
+            for (int index = 0; index < joinPlans.count(); ++index) {
+                const JoinPlan &joinPlan = joinPlans[index];
+                const QSharedPointer<ITableModel> &row = current[index];
+                if (!row) {
+                    continue;
+                }
+
+                if (joinPlan.referenceOrdinal >= 0) {
+                    tableObj.getColumn(joinPlan.referenceOrdinal)->
+                        setReference(row);
+                }
+                else if (joinPlan.referencePlan >= 0 &&
+                         current[joinPlan.referencePlan]) {
+                    // Родительский объект из карты записей загружен без
+                    // этого присоединения: он связывается, если у ключа
+                    // ещё нет записи и значение ключа не изменено
+                    const DbColumn column = current[joinPlan.referencePlan]->
+                        getColumn(joinPlan.joined.referenceColumn);
+                    if (created[joinPlan.referencePlan] ||
+                        (!column->getReference() &&
+                         column->getModelValue().toLongLong() ==
+                             records.value(joinPlan.keyIndex).toLongLong())) {
+                        column->setReference(row);
+                    }
+                }
+            }
         }
 
         QVector<QString> parseExpression(
             const QSharedPointer<ExpressionNode>&) const;
 
+        /*
+         * Список выбора для project и projectInto: без select или с
+         * другим числом колонок значения попали бы не в те элементы,
+         * поэтому запрос не выполняется, выражение сбрасывается.
+         */
+        void checkProjection(int fieldCount);
+
     public:
         const ExpressionNodes getExpressionNodes() const override
         { return _expression_nodes_; }
 
+        /*
+         * Объекты результатов не регистрируются в контексте как его
+         * таблицы, а только получают указатель на контекст.
+         */
         template <class Table>
         Table toObject() {
-            QSharedPointer<Table> table = objectPrepare<Table>();
-            QSqlQuery records =
-                table->getTableContext()->proceedExpression(*this);
-
-            if (records.first()) {
-                Table tableObj = Table(table->getModelName(),
-                                       table->getTableContext());
-
-                ushort index = 0;
-                for (const QString &node :
-                     qAsConst(_expression_nodes_[QueryClause::SELECT])) {
-                    DbColumn column = tableObj[node];
-                    if (column) {
-                        column->setModelValue(records.value(index++));
-                    }
-                }
+            const Table &table = objectPrepare<Table>();
+            JoinPlans joinPlans = prepareJoins(table);
+            const IncludePlans &includePlans = prepareIncludes(table);
+            const DecodePlan &plan = prepareDecodePlan(table);
+            RecordCursor records(table.getTableContext(), *this);
+            clearExpression();
+
+            if (records.next()) {
+                QVector<Table> tables(1);
+                Table &tableObj = tables.first();
+                tableObj.registerContext(table.getTableContext());
+
+                hydrate(tableObj, records, plan);
+                hydrateJoins(tableObj, records, joinPlans);
+                loadIncludes(tables, includePlans);
                 return std::move(tableObj);
             }
 
             return Table();
         }
 
+    private:
+        /*
+         * Конвейерное чтение (см. parallel): поток вызова только читает
+         * записи курсора и копирует их значения блоками, а создание
+         * и заполнение объектов блока выполняется в пуле потоков,
+         * пока поток вызова ждёт следующие записи от СУБД. Результаты
+         * блоков собираются в порядке записей результата запроса.
+         */
+        template <class Table>
+        QVector<Table> toObjectListPipelined(DbContext context,
+                                             const DecodePlan &plan,
+                                             int recordSize,
+                                             RecordCursor &records,
+                                             int blockSize) {
+            using Block = QVector<QVector<QVariant>>;
+            // Объекты записей создаются сразу в векторе результата блока
+            auto hydrateBlock = [context, plan](const Block &block) {
+                QVector<Table> tables(block.count());
+                for (int row = 0; row < block.count(); ++row) {
+                    tables[row].registerContext(context);
+                    hydrate(tables[row], block[row], plan);
+                }
+                return tables;
+            };
+
+            QVector<QFuture<QVector<Table>>> blocks;
+            Block block;
+            block.reserve(blockSize);
+            while (records.next()) {
+                QVector<QVariant> record(recordSize);
+                for (int index = 0; index < recordSize; ++index) {
+                    record[index] = records.value(index);
+                }
+                block.append(record);
+
+                if (block.count() == blockSize) {
+                    blocks.append(QtConcurrent::run(
+                        QThreadPool::globalInstance(), hydrateBlock, block));
+                    block = Block();
+                    block.reserve(blockSize);
+                }
+            }
+            if (!block.isEmpty()) {
+                blocks.append(QtConcurrent::run(
+                    QThreadPool::globalInstance(), hydrateBlock, block));
+            }
+
+            QVector<Table> tables;
+            tables.reserve(blocks.count() * blockSize);
+            for (QFuture<QVector<Table>> &future : blocks) {
+                QVector<Table> blockTables = future.result();
+                for (Table &tableObj : blockTables) {
+                    tables.append(std::move(tableObj));
+                }
+            }
+            return tables;
+        }
+
+    public:
         template <class Table>
         QVector<Table> toObjectList() {
             QVector<Table> tables;
-            QSharedPointer<Table> table = objectPrepare<Table>();
-            QSqlQuery records =
-                table->getTableContext()->proceedExpression(*this);
+            const Table &table = objectPrepare<Table>();
+            JoinPlans joinPlans = prepareJoins(table);
+            const IncludePlans &includePlans = prepareIncludes(table);
+            const DecodePlan &plan = prepareDecodePlan(table);
+            const int blockSize = (joinPlans.isEmpty()) ? _parallel_block_ : 0;
+            const int recordSize =
+                _expression_nodes_.value(QueryClause::SELECT).count();
+            RecordCursor records(table.getTableContext(), *this);
+            clearExpression();
+
+            if (blockSize > 0) {
+                tables = toObjectListPipelined<Table>(
+                    table.getTableContext(), plan, recordSize, records,
+                    blockSize);
+                groupReferences(tables, plan);
+                loadIncludes(tables, includePlans);
+                return tables;
+            }
 
+            /*
+             * Объект записи заполняется сразу в векторе результата: имя
+             * таблицы задаёт схема типа, поэтому объект по умолчанию
+             * совпадает с объектом таблицы запроса. При росте вектора
+             * записи переносятся (Table(Table&&)), а не копируются.
+             */
+            if (records.getQuery().size() > 0) {
+                tables.reserve(records.getQuery().size());
+            }
             while (records.next()) {
-                Table tableObj = Table(table->getModelName(),
-                                       table->getTableContext());
-
-                ushort index = 0;
-                for (const QString &node :
-                     qAsConst(_expression_nodes_[QueryClause::SELECT])) {
-                    DbColumn column = tableObj[node];
-                    if (column) {
-                        column->setModelValue(records.value(index++));
-                    }
-                }
-                tables.append(std::move(tableObj));
+                tables.resize(tables.count() + 1);
+                Table &tableObj = tables.last();
+                tableObj.registerContext(table.getTableContext());
+
+                hydrate(tableObj, records, plan);
+                hydrateJoins(tableObj, records, joinPlans);
             }
 
+            groupReferences(tables, plan);
+            loadIncludes(tables, includePlans);
             return tables;
         }
 
+        /*!
+         *  Потоковое чтение результата запроса:
+         *  for (EmployeeTable &employee :
+         *       context.employees.select(...).stream<EmployeeTable>()) { ... }
+         *  Записи читаются только вперёд, в памяти находится один объект
+         *  текущей записи, поэтому выгрузка любого объёма данных не
+         *  требует памяти, растущей с размером результата.
+         *  Если задан размер пула (poolSize > 0), то объекты записей
+         *  создаются один раз и по кругу заполняются следующими записями:
+         *  при переборе не выделяется память и не меняются реестры таблиц
+         *  и колонок. Объект записи остаётся действительным, пока не
+         *  прочитаны следующие poolSize записей.
+         */
+        template <class Table>
+        QueryStream<Table> stream(int poolSize = 0) {
+            const Table &table = objectPrepare<Table>();
+            QueryStream<Table> queryStream(table.getModelName(),
+                table.getTableContext(), prepareDecodePlan(table), *this,
+                poolSize);
+            clearExpression();
+            return queryStream;
+        }
+
+        /*!
+         *  Обработка каждой записи результата запроса без накопления
+         *  результатов: forEach<EmployeeTable>([](EmployeeTable &row) {...})
+         *  Объект записи действителен только во время вызова обработчика,
+         *  поэтому для всех записей используется один и тот же объект.
+         */
+        template <class Table, typename Callback>
+        void forEach(Callback callback) {
+            stream<Table>(1).forEach(callback);
+        }
+
+        /*!
+         *  Выборка записей в кортежи без создания моделей таблиц:
+         *  select(COL(employees.Id), COL(employees.FirstName))
+         *      .project<std::tuple<int, QString>>();
+         *  Элементы кортежа заполняются по порядку выбранных колонок,
+         *  число колонок должно совпадать с числом элементов.
+         */
+        template <class Tuple>
+        QVector<Tuple> project() {
+            checkProjection(std::tuple_size<Tuple>::value);
+
+            QVector<Tuple> rows;
+            RecordCursor records(_table->getTableContext(), *this);
+            clearExpression();
+
+            while (records.next()) {
+                Tuple row;
+                TupleReader<std::tuple_size<Tuple>::value, Tuple>::
+                    read(records, row);
+                rows.append(row);
+            }
+
+            return rows;
+        }
+
+        /*!
+         *  Выборка записей в простые структуры без создания моделей таблиц:
+         *  select(COL(employees.Id), COL(employees.FirstName))
+         *      .projectInto<EmployeeRow>(&EmployeeRow::id, &EmployeeRow::name);
+         *  Поля структуры заполняются по порядку выбранных колонок,
+         *  число колонок должно совпадать с числом полей.
+         */
+        template <class Struct, typename ...Fields>
+        QVector<Struct> projectInto(Fields Struct::*...fields) {
+            checkProjection(sizeof...(Fields));
+
+            QVector<Struct> rows;
+            RecordCursor records(_table->getTableContext(), *this);
+            clearExpression();
+
+            while (records.next()) {
+                Struct row;
+                int index = 0;
+                // Элементы списка инициализации вычисляются слева направо
+                using expander = int[];
+                (void)expander { 0, (row.*fields = records.value(index++).
+                    template value<Fields>(), 0)... };
+                rows.append(row);
+            }
+
+            return rows;
+        }
+
+        /*!
+         *  Выборка записей по колонкам для аналитических запросов:
+         *  select(COL(employees.DepartmentId), COL(employees.Salary))
+         *      .toColumns();
+         *  Каждая выбранная колонка хранится одним непрерывным вектором
+         *  своего типа (см. ColumnBatch). Если колонки не выбраны,
+         *  выбираются все колонки таблицы запроса, кроме отложенных.
+         */
+        ColumnBatch toColumns();
+
+        /*!
+         *  Выборка записей в компактный набор (см. RowSet):
+         *  employees.select(...).toRows<EmployeeTable>();
+         *  Записи хранятся в одном буфере по раскладке типа таблицы,
+         *  без объектов таблиц и колонок. Если колонки не выбраны,
+         *  выбираются все колонки таблицы, кроме отложенных.
+         */
+        template <class Table>
+        RowSet toRows() {
+            const Table &table = objectPrepare<Table>();
+            QVector<int> ordinals(
+                _expression_nodes_.value(QueryClause::SELECT).count(), -1);
+            for (const DecodeStep &step : prepareDecodePlan(table)) {
+                if (step.index >= 0) {
+                    ordinals[step.index] = step.ordinal;
+                }
+            }
+
+            RowSet rows(Table::rowLayout());
+            RecordCursor records(table.getTableContext(), *this);
+            clearExpression();
+
+            if (records.getQuery().size() > 0) {
+                rows.reserve(records.getQuery().size());
+            }
+            while (records.next()) {
+                rows.append(records, ordinals);
+            }
+
+            return rows;
+        }
+
         template <typename ...Columns>
         ExpressionHandler& select(Columns ...selectNode) {
             std::array<COL, sizeof...(Columns)> const nodes { selectNode... };
             for (const COL& node : nodes) {
                 _expression_nodes_[QueryClause::SELECT]
                     .append(node.operator QString().trimmed());
+                _select_columns_.append(node.getColumn());
+            }
+            return *this;
+        }
+
+        /*!
+         *  Загрузка записей таблицы по значениям первичного ключа запросами
+         *  WHERE Id IN (...) по chunkSize значений. Возвращает записи
+         *  по значению первичного ключа. Записи, уже загруженные в
+         *  контекст, берутся из его карты записей, новые добавляются в неё.
+         */
+        template <class Table>
+        static QHash<qlonglong, QSharedPointer<ITableModel>> loadRows(
+                DbContext context, const QVector<QVariant> &values,
+                int chunkSize = 1000) {
+            QHash<qlonglong, QSharedPointer<ITableModel>> rows;
+            // Записи без контекста (например, из RowSet) загрузить неоткуда
+            if (!context) {
+                return rows;
+            }
+
+            // Записи, уже загруженные в контекст, повторно не запрашиваются
+            QVector<QVariant> missing;
+            for (const QVariant &value : values) {
+                const QSharedPointer<ITableModel> &row =
+                    context->findRow(Table::modelName(), value.toLongLong());
+                if (row) {
+                    rows[value.toLongLong()] = row;
+                }
+                else {
+                    missing.append(value);
+                }
+            }
+
+            for (int offset = 0; offset < missing.count();
+                 offset += chunkSize) {
+                Table loader(Table::typeName(), nullptr);
+                loader.registerContext(context);
+                loader.setQueryTable(static_cast<DbTable>(&loader));
+
+                COL keyColumn(loader.getPkColumn());
+                loader.where(keyColumn.in(missing.mid(offset, chunkSize)));
+
+                QVector<Table> loadedRows = loader.template toObjectList<Table>();
+                for (Table &row : loadedRows) {
+                    const qlonglong key =
+                        row.getPkColumn()->getModelValue().toLongLong();
+                    QSharedPointer<ITableModel> loaded =
+                        QSharedPointer<Table>::create(std::move(row));
+                    if (context) {
+                        loaded = context->registerRow(loaded);
+                    }
+                    rows[key] = loaded;
+                }
             }
+            return rows;
+        }
+
+        /*!
+         *  Загрузка записей таблицы, на которую ссылается вторичный ключ
+         *  таблицы запроса: .include<DepartmentTable>().toObjectList<...>()
+         *  После основного запроса собираются различные значения ключа,
+         *  и записи загружаются запросами WHERE Id IN (...) по chunkSize
+         *  значений. Каждая запись загружается один раз и связывается со
+         *  всеми записями, которые на неё ссылаются (employee.DepartmentId.get()).
+         *  Для страницы из 500 записей это 2 запроса вместо 501.
+         */
+        template <class Table>
+        ExpressionHandler& include(int chunkSize = 1000) {
+            IncludedTable included;
+            included.tableName = Table::modelName();
+            included.load = [chunkSize](DbContext context,
+                                        const QVector<DbColumn> &keys) {
+                QVector<QVariant> values;
+                QSet<qlonglong> distinct;
+                for (const DbColumn key : keys) {
+                    const QVariant &value = key->getModelValue();
+                    if (!key->isNull() &&
+                        !distinct.contains(value.toLongLong())) {
+                        distinct.insert(value.toLongLong());
+                        values.append(value);
+                    }
+                }
+
+                const QHash<qlonglong, QSharedPointer<ITableModel>> &rows =
+                    loadRows<Table>(context, values, chunkSize);
+                for (const DbColumn key : keys) {
+                    if (!key->isNull()) {
+                        key->setReference(
+                            rows.value(key->getModelValue().toLongLong()));
+                    }
+                }
+            };
+            _included_tables_.append(included);
             return *this;
         }
 
+        /*!
+         *  Присоединение таблицы. Если условие связывает вторичный ключ
+         *  с первичным ключом присоединяемой таблицы, то toObject
+         *  и toObjectList заполняют и объекты этой таблицы: каждая
+         *  запись создаётся один раз на значение первичного ключа
+         *  и разделяется всеми записями, которые на неё ссылаются
+         *  (employee.DepartmentId->CompanyId->Name).
+         */
         template <class Table>
         ExpressionHandler& join(const COL &joinColumn) {
-            Table table = Table(
-                abi::__cxa_demangle(typeid(table).name(),0,0,nullptr), nullptr);
+            registerJoin<Table>(Table::modelName(), joinColumn);
 
             DbType dbType = joinColumn.getColumn()->
                 getTable()->getTableContext()->getDbType();
 
             QString tbName = (dbType == DbType::POSTGRES)
-                ? "\"" + table.getModelName() + "\""
-                : table.getModelName();
+                ? "\"" + Table::modelName() + "\""
+                : Table::modelName();
 
             QString joinNode =
                 joinColumn.getExpression().data()->operator QString();
@@ -187,8 +1050,174 @@ namespace jara_lib {
             return *this;
         }
 
+        /*!
+         *  Размер части результата, получаемой с сервера за одно обращение.
+         *  В PostgreSQL запрос выполняется через курсор (DECLARE ... CURSOR,
+         *  FETCH n) внутри транзакции, поэтому ни память клиента, ни время
+         *  до первой записи не зависят от размера результата. Для других
+         *  СУБД результат читается однонаправленным курсором драйвера.
+         */
+        ExpressionHandler& fetchSize(int size) {
+            _fetch_size_ = size;
+            return *this;
+        }
+
+        /*!
+         *  Общая таблица строк для всех строковых колонок запроса:
+         *  равные значения разделяют один объект QString. Для отдельных
+         *  колонок таблица строк включается объявлением Interned<String>,
+         *  для колонок присоединённых таблиц (join) - всегда.
+         */
+        ExpressionHandler& intern() {
+            _intern_strings_ = true;
+            return *this;
+        }
+
+        /*!
+         *  Конвейерный режим toObjectList: записи читаются из курсора
+         *  блоками по blockSize записей, а объекты таблиц создаются
+         *  и заполняются в глобальном пуле потоков (QThreadPool).
+         *  Ожидание данных от СУБД совмещается с заполнением объектов,
+         *  что заметно для широких записей с большим числом строк.
+         *  Запросы с заполнением присоединённых таблиц (join) читаются
+         *  последовательно: общие объекты записей создаются по порядку.
+         */
+        ExpressionHandler& parallel(int blockSize = 256) {
+            _parallel_block_ = blockSize;
+            return *this;
+        }
+
     private:
         DbTable _table;
         ExpressionNodes _expression_nodes_;
+        //! Колонки списка выбора (nullptr для вычисляемых выражений)
+        QVector<DbColumn> _select_columns_;
+        int _fetch_size_ = 0;
+        int _parallel_block_ = 0;
+        bool _intern_strings_ = false;
+        mutable QSharedPointer<StringPool> _string_pool_;
+        QVector<JoinedTable> _joined_tables_;
+        QVector<IncludedTable> _included_tables_;
+    };
+
+    /*!
+     *  Условия существования записей в подзапросе. Подзапрос может
+     *  ссылаться на колонки внешнего запроса (коррелированный подзапрос):
+     *  exists(context.departments.where(
+     *      COL(context.departments.Id) == COL(context.employees.DepartmentId)))
+     */
+    COL exists(ExpressionHandler&);
+    COL notExists(ExpressionHandler&);
+
+    /*!
+     *  Поток записей результата запроса для перебора в цикле for.
+     *  Итератор потока однопроходный: каждый шаг читает следующую
+     *  запись и заменяет ею объект текущей записи. Объекты записей
+     *  создаются для каждой записи или берутся по кругу из пула.
+     */
+    template <class Table>
+    class QueryStream {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = Table;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Table*;
+            using reference = Table&;
+
+            explicit iterator(QueryStream *queryStream = nullptr)
+                : _stream(queryStream) {}
+
+            Table& operator*() const
+            { return *_stream->_row; }
+
+            Table* operator->() const
+            { return _stream->_row.data(); }
+
+            iterator& operator++() {
+                if (!_stream->fetch()) {
+                    _stream = nullptr;
+                }
+                return *this;
+            }
+
+            bool operator==(const iterator &other) const
+            { return _stream == other._stream; }
+
+            bool operator!=(const iterator &other) const
+            { return _stream != other._stream; }
+
+        private:
+            QueryStream *_stream;
+        };
+
+    public:
+        QueryStream(const QString &tableName, DbContext context,
+                    const DecodePlan &plan,
+                    const IExpressionHandler &expression,
+                    int poolSize = 0)
+            : _tableName(tableName), _context(context), _plan(plan),
+              _records(QSharedPointer<RecordCursor>::create(
+                  context, expression)) {
+            _pool.reserve(poolSize);
+            for (int index = 0; index < poolSize; ++index) {
+                _pool.append(createRow());
+            }
+        }
+
+        iterator begin()
+        { return (fetch()) ? iterator(this) : iterator(); }
+
+        iterator end()
+        { return iterator(); }
+
+        template <typename Callback>
+        void forEach(Callback callback) {
+            while (fetch()) {
+                callback(*_row);
+            }
+        }
+
+    private:
+        QSharedPointer<Table> createRow() const {
+            QSharedPointer<Table> row =
+                QSharedPointer<Table>::create(_tableName, nullptr);
+            row->registerContext(_context);
+            return row;
+        }
+
+        /* Чтение следующей записи в объект текущей записи */
+        bool fetch() {
+            if (_pool.isEmpty()) {
+                // Объект предыдущей записи удаляется до чтения следующей
+                _row.reset();
+                if (!_records->next()) {
+                    return false;
+                }
+                _row = createRow();
+            }
+            else {
+                if (!_records->next()) {
+                    return false;
+                }
+                _row = _pool[_poolIndex];
+                _poolIndex = (_poolIndex + 1) % _pool.count();
+                _row->resetValues();
+            }
+
+            ExpressionHandler::hydrate(*_row, *_records, _plan);
+            return true;
+        }
+
+    private:
+        QString _tableName;
+        DbContext _context;
+        DecodePlan _plan;
+        QSharedPointer<RecordCursor> _records;
+        QSharedPointer<Table> _row;
+        // Объекты записей для повторного использования
+        QVector<QSharedPointer<Table>> _pool;
+        int _poolIndex = 0;
     };
 };
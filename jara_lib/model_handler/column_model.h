@@ -3,58 +3,36 @@
 #include "table_model.h"
 
 namespace jara_lib {
+    /*!
+     *  Колонка записи таблицы (ColumnModel). Объект колонки хранит только
+     *  значение и его состояние, указатель на свою таблицу и номер в ней:
+     *  имя колонки берётся из схемы типа таблицы. Связанные записи,
+     *  отложенная загрузка и блоки ключей есть только у колонок
+     *  ForeignKey, Deferred и PrimaryKey (см. column_types.h), у
+     *  остальных колонок соответствующие методы ничего не хранят.
+     */
     class ColumnModel : public IColumnModel {
     public:
         explicit ColumnModel(const QString &columnName,
                              DbTable table, ColumnType type)
             : _fieldType(FieldType::STRAIGHT_FIELD), _commandType(type) {
-            if (table) {
-                registerColumn(table);
-            }
-            setColumnName(columnName);
-        }
-
-        ~ColumnModel() {
-            // Если указатель на имя колонки не пуст
-            if (_columnName) {
-                // Находим в реестре таблиц запись с данным именем
-                TableModel *t = static_cast<TableModel*>(_columnTable);
-                t->getTableName();
-                TableRegister::iterator tb =
-                    _register_tables_.find(_columnTable->getModelName());
-                // Получаем указатель на имя таблицы
-                QString *tableName = const_cast<QString*>(&tb->first);
-                // Создаем пару из имени колонки и имени таблицы
-                TableColumn tc = std::make_pair(tableName, *_columnName);
-                // Удаляем такую запись из реестра колонок
-                _register_columns_[tc].remove(this);
-                // Если коллекция подобных колонок пуста,
-                // удаляем полностью запись таблицы
-                if (_register_columns_[tc].count() == 0) {
-                    _register_columns_.erase(tc);
-                }
-            }
+            registerColumn(table);
+            // Первый объект типа таблицы заполняет имена колонок схемы
+            static_cast<TableModel*>(table)->getSchemaColumnName(columnName);
         }
 
-        void setColumnName(const QString &columnName) {
-            if (_columnName) {
-                *_columnName = columnName;
-            }
-            else {
-                TableRegister::iterator tb =
-                    _register_tables_.find(_columnTable->getModelName());
-                QString *tableName = const_cast<QString*>(&tb->first);
-                TableColumn tc = std::make_pair(tableName, columnName);
-
-                _register_columns_[tc].insert(this);
-                ColumnRegister::iterator reg = _register_columns_.find(tc);
-                _columnName = const_cast<QString*>(&reg->first.second);
-            }
-        }
+        /*!
+         *  Переименование колонки (ColumnModel). Имя хранится в схеме
+         *  типа таблицы, поэтому меняется у всех записей этого типа.
+         */
+        void setColumnName(const QString &columnName)
+        { static_cast<TableModel*>(_columnTable)->
+            setSchemaColumnName(_ordinal, columnName); }
 
         void registerColumn(DbTable table) {
             _columnTable = table;
             _columnTable->registerModel(this);
+            _ordinal = static_cast<TableModel*>(table)->getColumnCount() - 1;
         }
 
         void registerModel(DbTable table) override
@@ -64,7 +42,8 @@ namespace jara_lib {
         { return _columnTable; }
 
         QString getColumnName() const
-        { return (_columnName) ? *_columnName : ""; }
+        { return static_cast<TableModel*>(_columnTable)->
+            getSchemaColumnName(_ordinal); }
 
         QString getModelName() const override
         { return getColumnName(); }
@@ -81,9 +60,48 @@ namespace jara_lib {
         void setType(ColumnType type)
         { _commandType = type; }
 
-        void setValueState(ValueState state)
+        ValueState getValueState() const override
+        { return _valueState; }
+
+        void setValueState(ValueState state) override
         { _valueState = state; }
 
+        bool isNull() const override
+        { return _null; }
+
+        int getKeyBlockSize() const override
+        { return 0; }
+
+        /*
+         * Связанная запись и группа ключей хранятся только колонками
+         * вторичных и отложенных ключей, для остальных колонок запись
+         * игнорируется (например, при сбросе значений записи).
+         */
+        void setReference(const QSharedPointer<ITableModel>&) override {}
+
+        QSharedPointer<ITableModel> getReference() const override
+        { return QSharedPointer<ITableModel>(); }
+
+        void setReferenceGroup(const QSharedPointer<ReferenceGroup>&) override {}
+
+        QSharedPointer<ReferenceGroup> getReferenceGroup() const override
+        { return QSharedPointer<ReferenceGroup>(); }
+
+        DbTable getReferencedTable() const override
+        { return nullptr; }
+
+        bool isDeferred() const override
+        { return false; }
+
+        // Не загруженным бывает только значение отложенной колонки
+        bool isLoaded() const override
+        { return true; }
+
+        void setLoaded(bool) override {}
+
+        bool isInterned() const override
+        { return false; }
+
         virtual void setColumnValue(const QVariant &value) = 0;
 
         void setModelValue(const QVariant &value) override {
@@ -118,85 +136,170 @@ namespace jara_lib {
     protected:
         FieldType _fieldType;
         ColumnType _commandType;
+        // Значение колонки NULL: прочитано из базы или задано пустым
+        // QVariant. Значение по умолчанию типа при этом не передаётся
+        bool _null = false;
 
     private:
-        QString *_columnName = nullptr;
-        DbTable _columnTable;
+        // Номер колонки в таблице и в схеме типа таблицы
+        int _ordinal = -1;
+        DbTable _columnTable = nullptr;
+    };
+
+    /*!
+     *  Свойства типа значения колонки для TypedColumn: тип колонки в СУБД,
+     *  тип QMetaType, в котором драйвер возвращает значение, и
+     *  преобразование из QVariant другого типа.
+     */
+    template <typename Value> struct ColumnTraits;
+
+    template <> struct ColumnTraits<int> {
+        static constexpr ColumnType columnType = ColumnType::INT;
+        static constexpr int metaType = QMetaType::Int;
+        static int fromVariant(const QVariant &value)
+        { return value.toInt(); }
+    };
+
+    template <> struct ColumnTraits<long long> {
+        static constexpr ColumnType columnType = ColumnType::BIGINT;
+        static constexpr int metaType = QMetaType::LongLong;
+        static long long fromVariant(const QVariant &value)
+        { return value.toLongLong(); }
     };
 
-    class IntColumn : public ColumnModel {
+    template <> struct ColumnTraits<QString> {
+        static constexpr ColumnType columnType = ColumnType::STRING_NULL;
+        static constexpr int metaType = QMetaType::QString;
+        static QString fromVariant(const QVariant &value)
+        { return value.toString(); }
+    };
+
+    /*!
+     *  Колонка со значением типа Value (TypedColumn).
+     *  Значение хранится в колонке как есть и доступно без виртуальных
+     *  вызовов (value, setValue, operator==), поэтому в циклах по
+     *  колонкам известного типа доступ к значению встраивается.
+     *  Виртуальные методы IColumnModel объявлены final и нужны только
+     *  там, где тип колонки неизвестен (запросы по DbColumn, описание
+     *  таблиц). Значения результата запроса записываются функцией
+     *  decode: значение, которое драйвер вернул в типе Value, читается
+     *  из QVariant напрямую, без преобразования.
+     */
+    template <typename Value, class Traits = ColumnTraits<Value>>
+    class TypedColumn : public ColumnModel {
     public:
-        explicit IntColumn(const QString &tableName, DbTable table,
-                           ColumnType type = ColumnType::INT)
-            : ColumnModel(tableName, table, type) {}
+        using ValueType = Value;
 
-        IntColumn(const QString &tableName)
-            : IntColumn(tableName, nullptr, ColumnType::INT) {}
+        explicit TypedColumn(const QString &columnName, DbTable table,
+                             ColumnType type = Traits::columnType)
+            : ColumnModel(columnName, table, type) {}
 
-        QVariant getModelValue() const override
+        const Value& value() const
         { return _value; }
 
-        operator int() const
-        { return _value; }
+        /*! Изменение значения без виртуальных вызовов (TypedColumn) */
+        void setValue(const Value &value) {
+            _value = value;
+            _null = false;
+            _valueState = ValueState::CHANGED;
+        }
 
-        void setColumnValue(const QVariant &value) override
-        { _value = value.toInt(); }
+        QVariant getModelValue() const final
+        { return (_null) ? QVariant() : QVariant(_value); }
 
-        bool operator==(int value) const
+        void setColumnValue(const QVariant &value) final {
+            _null = value.isNull();
+            _value = (_null) ? Value() : Traits::fromVariant(value);
+        }
+
+        /*! Запись значения результата без виртуальных вызовов (TypedColumn) */
+        static void decode(DbColumn column, const QVariant &value) {
+            TypedColumn *typedColumn = static_cast<TypedColumn*>(column);
+            typedColumn->_null = value.isNull();
+            typedColumn->_value = (typedColumn->_null) ? Value()
+                : (value.userType() == Traits::metaType)
+                ? *static_cast<const Value*>(value.constData())
+                : Traits::fromVariant(value);
+            typedColumn->_valueState = ValueState::ADDED;
+        }
+
+        ColumnDecoder getDecoder() const final
+        { return &TypedColumn::decode; }
+
+        /*!
+         *  Копирование значения и его состояния из колонки того же типа
+         *  (TypedColumn) - при копировании записей. Колонки вторичных и
+         *  отложенных ключей копируют также связанные записи.
+         */
+        void copyValue(DbColumn source) override {
+            const TypedColumn *column = static_cast<const TypedColumn*>(source);
+            _value = column->_value;
+            _null = column->_null;
+            _valueState = column->_valueState;
+        }
+
+        /*! Перенос значения из колонки того же типа (TypedColumn) */
+        void moveValue(DbColumn source) override {
+            TypedColumn *column = static_cast<TypedColumn*>(source);
+            _value = std::move(column->_value);
+            _null = column->_null;
+            _valueState = column->_valueState;
+        }
+
+        bool operator==(const Value &value) const
         { return _value == value; }
 
-        bool operator==(const IntColumn &column) const
+        bool operator==(const TypedColumn &column) const
         { return _value == column._value; }
 
+        bool operator!=(const Value &value) const
+        { return _value != value; }
+
+    protected:
+        Value _value = Value();
+    };
+
+    class IntColumn : public TypedColumn<int> {
+    public:
+        explicit IntColumn(const QString &tableName, DbTable table,
+                           ColumnType type = ColumnType::INT)
+            : TypedColumn(tableName, table, type) {}
+
+        operator int() const
+        { return _value; }
+
         IntColumn& operator=(int value) {
             changeModelValue(value);
             return *this;
         }
-
-    private:
-        int _value;
     };
 
-    class BigIntColumn : public ColumnModel {
+    class BigIntColumn : public TypedColumn<long long> {
     public:
         explicit BigIntColumn(const QString &tableName, DbTable table,
                            ColumnType type = ColumnType::BIGINT)
-            : ColumnModel(tableName, table, type) {}
-
-        BigIntColumn(const QString &tableName)
-            : BigIntColumn(tableName, nullptr, ColumnType::BIGINT) {}
+            : TypedColumn(tableName, table, type) {}
 
-        QVariant getModelValue() const override
+        operator long long() const
         { return _value; }
 
-        void setColumnValue(const QVariant &value) override
-        { _value = value.toLongLong(); }
-
         BigIntColumn& operator=(long long value) {
             changeModelValue(value);
             return *this;
         }
-
-    private:
-        long long _value;
     };
 
-    class StringColumn : public ColumnModel {
+    /*
+     * Строка, которую вернул драйвер, не копируется в decode, а
+     * разделяется с QVariant (неявное разделение данных QString).
+     */
+    class StringColumn : public TypedColumn<QString> {
     public:
         explicit StringColumn(const QString &tableName,
                               DbTable table, int size = 0)
-            : ColumnModel(tableName, table, ColumnType::STRING_NULL),
+            : TypedColumn(tableName, table, ColumnType::STRING_NULL),
               _columnSize(QString("(") + ((size) ? QString::number(size) : "MAX") + ")") {}
 
-        StringColumn(const QString &tableName)
-            : StringColumn(tableName, nullptr, ColumnType::STRING_NULL) {}
-
-        QVariant getModelValue() const override
-        { return _value; }
-
-        void setColumnValue(const QVariant &value) override
-        { _value = value.toString(); }
-
         StringColumn& operator=(const QString &value) {
             changeModelValue(value);
             return *this;
@@ -204,6 +307,5 @@ namespace jara_lib {
 
     private:
         const QString _columnSize;
-        QString _value;
     };
 };
@@ -4,14 +4,170 @@
 
 namespace jara_lib {
 
-    template <typename T> class PrimaryKey;
-    template <> class PrimaryKey<IntColumn> {
+    /*!
+     *  Способы получения значений первичного ключа:
+     *  SerialKey - ключ-счётчик, значение выдаёт СУБД при вставке записи;
+     *  HiLoKey<N> - ключи выдаются приложением из блоков по N значений,
+     *  которые резервируются в СУБД одним запросом (последовательность
+     *  в PostgreSQL, таблица последовательностей в MySQL и MS SQL Server).
+     *  Так ключ родительской записи известен до вставки дочерних записей.
+     */
+    struct SerialKey {
+        static const int BlockSize = 0;
+    };
+
+    template <int Size> struct HiLoKey {
+        static_assert(Size > 0, "The key block size must be positive");
+        static const int BlockSize = Size;
+    };
+
+    /*!
+     *  Колонка первичного ключа (PrimaryKey): размер блока ключей
+     *  задаётся способом получения ключа и в записи не хранится.
+     */
+    template <typename Column, typename KeyGenerator>
+    class KeyColumn : public Column {
     public:
-        explicit PrimaryKey<IntColumn>(
-            const QString& tableName, DbTable table)
-            : _column(IntColumn(
-                tableName, table, ColumnType::INT_SERIAL)) {
-            _column.setConstraint<TableModel>(
+        explicit KeyColumn(const QString &columnName,
+                           DbTable table, ColumnType type)
+            : Column(columnName, table, type) {}
+
+        int getKeyBlockSize() const override
+        { return KeyGenerator::BlockSize; }
+    };
+
+    /*!
+     *  Колонка вторичного ключа (ForeignKey): кроме значения хранит
+     *  объект записи, на которую ссылается ключ, и ключи записей того же
+     *  результата запроса. Таблица ключа задаётся типом колонки.
+     */
+    template <typename Column, typename Table>
+    class ForeignKeyColumn : public Column {
+    public:
+        explicit ForeignKeyColumn(const QString &columnName, DbTable table)
+            : Column(columnName, table) {}
+
+        using Column::operator=;
+
+        void setReference(const QSharedPointer<ITableModel> &reference) override
+        { _reference = reference; }
+
+        QSharedPointer<ITableModel> getReference() const override
+        { return _reference; }
+
+        void setReferenceGroup(
+            const QSharedPointer<ReferenceGroup> &referenceGroup) override
+        { _referenceGroup = referenceGroup; }
+
+        QSharedPointer<ReferenceGroup> getReferenceGroup() const override
+        { return _referenceGroup; }
+
+        /*
+         * Образец таблицы создаётся при первом обращении, а не при
+         * создании колонки: иначе таблица с ключом на свой же тип
+         * создавалась бы во время собственного создания.
+         */
+        DbTable getReferencedTable() const override
+        { return Table::tablePrototype(); }
+
+        void copyValue(DbColumn source) override {
+            Column::copyValue(source);
+            const ForeignKeyColumn *column =
+                static_cast<const ForeignKeyColumn*>(source);
+            _reference = column->_reference;
+            _referenceGroup = column->_referenceGroup;
+        }
+
+        void moveValue(DbColumn source) override {
+            Column::moveValue(source);
+            ForeignKeyColumn *column = static_cast<ForeignKeyColumn*>(source);
+            _reference = std::move(column->_reference);
+            _referenceGroup = std::move(column->_referenceGroup);
+        }
+
+    private:
+        // Объект записи, на которую ссылается ключ. Объект разделяется
+        // всеми записями, которые ссылаются на ту же запись
+        QSharedPointer<ITableModel> _reference;
+        // Ключи записей того же результата для загрузки связанных записей
+        QSharedPointer<ReferenceGroup> _referenceGroup;
+    };
+
+    /*!
+     *  Колонка отложенного значения (Deferred): признак незагруженного
+     *  значения и ключи записей того же результата запроса, по которым
+     *  значения загружаются сразу для всех этих записей. Значение не
+     *  загружено, только если запись прочитана запросом без этой
+     *  колонки; у новой записи значение считается загруженным.
+     */
+    class DeferredColumn : public StringColumn {
+    public:
+        explicit DeferredColumn(const QString &columnName,
+                                DbTable table, int size = 0)
+            : StringColumn(columnName, table, size) {}
+
+        DeferredColumn& operator=(const QString &value) {
+            StringColumn::operator=(value);
+            _loaded = true;
+            return *this;
+        }
+
+        bool isDeferred() const override
+        { return true; }
+
+        bool isLoaded() const override
+        { return _loaded; }
+
+        void setLoaded(bool loaded) override
+        { _loaded = loaded; }
+
+        void setReferenceGroup(
+            const QSharedPointer<ReferenceGroup> &referenceGroup) override
+        { _referenceGroup = referenceGroup; }
+
+        QSharedPointer<ReferenceGroup> getReferenceGroup() const override
+        { return _referenceGroup; }
+
+        void copyValue(DbColumn source) override {
+            StringColumn::copyValue(source);
+            const DeferredColumn *column =
+                static_cast<const DeferredColumn*>(source);
+            _referenceGroup = column->_referenceGroup;
+            _loaded = column->_loaded;
+        }
+
+        void moveValue(DbColumn source) override {
+            StringColumn::moveValue(source);
+            DeferredColumn *column = static_cast<DeferredColumn*>(source);
+            _referenceGroup = std::move(column->_referenceGroup);
+            _loaded = column->_loaded;
+        }
+
+    private:
+        QSharedPointer<ReferenceGroup> _referenceGroup;
+        bool _loaded = true;
+    };
+
+    /*! Колонка Interned: значения заполняются через таблицу строк запроса */
+    class InternedColumn : public StringColumn {
+    public:
+        explicit InternedColumn(const QString &columnName,
+                                DbTable table, int size = 0)
+            : StringColumn(columnName, table, size) {}
+
+        using StringColumn::operator=;
+
+        bool isInterned() const override
+        { return true; }
+    };
+
+    template <typename T, typename KeyGenerator = SerialKey> class PrimaryKey;
+    template <typename KeyGenerator> class PrimaryKey<IntColumn, KeyGenerator> {
+    public:
+        explicit PrimaryKey(const QString& tableName, DbTable table)
+            : _column(tableName, table, (KeyGenerator::BlockSize)
+                ? ColumnType::INT : ColumnType::INT_SERIAL) {
+            _column.template setConstraint<TableModel>(
                 FieldType::PRIMARY_KEY, nullptr);
         }
 
@@ -21,17 +177,19 @@ namespace jara_lib {
         operator DbColumn()
         { return _column; }
 
+        operator int() const
+        { return _column; }
+
     private:
-        IntColumn _column;
+        KeyColumn<IntColumn, KeyGenerator> _column;
     };
 
-    template <> class PrimaryKey<BigIntColumn> {
+    template <typename KeyGenerator> class PrimaryKey<BigIntColumn, KeyGenerator> {
     public:
-        explicit PrimaryKey<BigIntColumn>(
-            const QString& tableName, DbTable table)
-            : _column(BigIntColumn(
-                tableName, table, ColumnType::BIGINT_SERIAL)) {
-            _column.setConstraint<TableModel>(
+        explicit PrimaryKey(const QString& tableName, DbTable table)
+            : _column(tableName, table, (KeyGenerator::BlockSize)
+                ? ColumnType::BIGINT : ColumnType::BIGINT_SERIAL) {
+            _column.template setConstraint<TableModel>(
                 FieldType::PRIMARY_KEY, nullptr);
         }
 
@@ -41,8 +199,11 @@ namespace jara_lib {
         operator DbColumn()
         { return _column; }
 
+        operator long long() const
+        { return _column; }
+
     private:
-        BigIntColumn _column;
+        KeyColumn<BigIntColumn, KeyGenerator> _column;
     };
 
     template <typename T, typename Table> class ForeignKey;
@@ -50,13 +211,8 @@ namespace jara_lib {
     public:
         explicit ForeignKey<IntColumn, Table>(const QString& tableName,
                                               DbTable table)
-            : _column(IntColumn(tableName, table)) {
-
-            QString tbName =
-                abi::__cxa_demangle(typeid(Table).name(),0,0,nullptr);
-
-            _column.setConstraint<TableModel>(FieldType::FOREIGN_KEY,
-                static_cast<TableModel*>(new Table(tbName, nullptr)));
+            : _column(tableName, table) {
+            _column.template setConstraint<TableModel>(FieldType::FOREIGN_KEY, nullptr);
         }
 
         operator QString() const
@@ -65,22 +221,71 @@ namespace jara_lib {
         operator DbColumn()
         { return _column; }
 
+        operator int() const
+        { return _column; }
+
+        ForeignKey& operator=(int value) {
+            // Загруженная запись и её группа относятся к прежнему ключу
+            if (_column.isNull() || static_cast<int>(_column) != value) {
+                _column.setReference(nullptr);
+                _column.setReferenceGroup(nullptr);
+            }
+            _column = value;
+            return *this;
+        }
+
+        /*!
+         *  Объект записи, на которую ссылается ключ (ForeignKey).
+         *  Заполняется при чтении запроса с join этой таблицы.
+         */
+        QSharedPointer<Table> get() const
+        { return qSharedPointerCast<Table>(_column.getReference()); }
+
+        Table* operator->() const
+        { return get().data(); }
+
+        /*!
+         *  Загрузка записи, на которую ссылается ключ, при первом
+         *  обращении (ForeignKey). Если запись получена вместе с другими
+         *  записями результата запроса, то одним запросом загружаются
+         *  связанные записи для всего результата. Для ключа NULL и
+         *  записи без контекста (например, полученной из RowSet)
+         *  возвращается пустой указатель.
+         */
+        QSharedPointer<Table> load() {
+            if (_column.getReference() || _column.isNull() ||
+                !_column.getTable()) {
+                return get();
+            }
+            const DbContext context = _column.getTable()->getTableContext();
+            if (context) {
+                QSharedPointer<ReferenceGroup> referenceGroup =
+                    _column.getReferenceGroup();
+                if (!referenceGroup) {
+                    referenceGroup = QSharedPointer<ReferenceGroup>::create();
+                    referenceGroup->keys.append(_column.getModelValue());
+                }
+                if (!referenceGroup->loaded) {
+                    referenceGroup->rows = ExpressionHandler::loadRows<Table>(
+                        context, referenceGroup->keys);
+                    referenceGroup->loaded = true;
+                }
+                _column.setReference(referenceGroup->rows.value(
+                    _column.getModelValue().toLongLong()));
+            }
+            return get();
+        }
+
     private:
-        IntColumn _column;
+        ForeignKeyColumn<IntColumn, Table> _column;
     };
 
     template <typename Table> class ForeignKey<BigIntColumn, Table> {
     public:
         explicit ForeignKey<BigIntColumn, Table>(
             const QString& tableName, DbTable table)
-            : _column(BigIntColumn(
-                tableName, table)) {
-
-            QString tbName =
-                abi::__cxa_demangle(typeid(Table).name(),0,0,nullptr);
-
-            _column.setConstraint<TableModel>(FieldType::FOREIGN_KEY,
-                static_cast<TableModel*>(new Table(tbName, nullptr)));
+            : _column(tableName, table) {
+            _column.template setConstraint<TableModel>(FieldType::FOREIGN_KEY, nullptr);
         }
 
         operator QString() const
@@ -89,8 +294,63 @@ namespace jara_lib {
         operator DbColumn()
         { return _column; }
 
+        operator long long() const
+        { return _column; }
+
+        ForeignKey& operator=(long long value) {
+            // Загруженная запись и её группа относятся к прежнему ключу
+            if (_column.isNull() || static_cast<long long>(_column) != value) {
+                _column.setReference(nullptr);
+                _column.setReferenceGroup(nullptr);
+            }
+            _column = value;
+            return *this;
+        }
+
+        /*!
+         *  Объект записи, на которую ссылается ключ (ForeignKey).
+         *  Заполняется при чтении запроса с join этой таблицы.
+         */
+        QSharedPointer<Table> get() const
+        { return qSharedPointerCast<Table>(_column.getReference()); }
+
+        Table* operator->() const
+        { return get().data(); }
+
+        /*!
+         *  Загрузка записи, на которую ссылается ключ, при первом
+         *  обращении (ForeignKey). Если запись получена вместе с другими
+         *  записями результата запроса, то одним запросом загружаются
+         *  связанные записи для всего результата. Для ключа NULL и
+         *  записи без контекста (например, полученной из RowSet)
+         *  возвращается пустой указатель.
+         */
+        QSharedPointer<Table> load() {
+            if (_column.getReference() || _column.isNull() ||
+                !_column.getTable()) {
+                return get();
+            }
+            const DbContext context = _column.getTable()->getTableContext();
+            if (context) {
+                QSharedPointer<ReferenceGroup> referenceGroup =
+                    _column.getReferenceGroup();
+                if (!referenceGroup) {
+                    referenceGroup = QSharedPointer<ReferenceGroup>::create();
+                    referenceGroup->keys.append(_column.getModelValue());
+                }
+                if (!referenceGroup->loaded) {
+                    referenceGroup->rows = ExpressionHandler::loadRows<Table>(
+                        context, referenceGroup->keys);
+                    referenceGroup->loaded = true;
+                }
+                _column.setReference(referenceGroup->rows.value(
+                    _column.getModelValue().toLongLong()));
+            }
+            return get();
+        }
+
     private:
-        BigIntColumn _column;
+        ForeignKeyColumn<BigIntColumn, Table> _column;
     };
 
     template <typename T> class Nullable;
@@ -124,10 +384,118 @@ namespace jara_lib {
         StringColumn _column;
     };
 
+    /*!
+     *  Отложенная колонка: не входит в список выбора по умолчанию
+     *  (без select) и загружается при первом обращении через get().
+     *  Значения загружаются по первичному ключу сразу для всех записей
+     *  результата запроса, в котором была получена запись. Подходит для
+     *  больших текстовых колонок, которые не нужны в списках записей.
+     */
+    template <typename T> class Deferred;
+    template <> class Deferred<StringColumn> {
+    public:
+        explicit Deferred<StringColumn>(
+            const QString &tableName, DbTable table, int size = 0)
+            : _column(tableName, table, size) {
+            _column.setType(ColumnType::STRING_NULL);
+        }
+
+        operator QString() const
+        { return _column; }
+
+        operator DbColumn()
+        { return _column; }
+
+        /*!
+         *  Значение колонки (Deferred). Если запись прочитана запросом
+         *  без этой колонки, то значение загружается при первом вызове.
+         *  Для записи без сохранённого ключа ничего не загружается.
+         */
+        QString get() {
+            TableModel *table = static_cast<TableModel*>(_column.getTable());
+            const DbColumn keyColumn = (table) ? table->getPkColumn() : nullptr;
+            if (!_column.isLoaded() && keyColumn && !keyColumn->isNull() &&
+                keyColumn->getModelValue().toLongLong() != 0) {
+                const QVariant &key = keyColumn->getModelValue();
+
+                QSharedPointer<ReferenceGroup> referenceGroup =
+                    _column.getReferenceGroup();
+                if (!referenceGroup) {
+                    referenceGroup = QSharedPointer<ReferenceGroup>::create();
+                    referenceGroup->keys.append(key);
+                }
+                if (!referenceGroup->loaded) {
+                    referenceGroup->values = table->loadColumnValues(
+                        _column, referenceGroup->keys);
+                    referenceGroup->loaded = true;
+                }
+                _column.setModelValue(
+                    referenceGroup->values.value(key.toLongLong()));
+                _column.setLoaded(true);
+            }
+            return _column.getModelValue().toString();
+        }
+
+        Deferred& operator=(const QString &value) {
+            _column = value;
+            return *this;
+        }
+
+    private:
+        DeferredColumn _column;
+    };
+
+    /*!
+     *  Строковая колонка с небольшим числом различных значений
+     *  (названия, коды, статусы): при чтении результата запроса равные
+     *  значения разделяют один объект QString.
+     */
+    template <typename T> class Interned;
+    template <> class Interned<StringColumn> {
+    public:
+        explicit Interned<StringColumn>(
+            const QString &tableName, DbTable table, int size = 0)
+            : _column(tableName, table, size) {}
+
+        operator QString() const
+        { return _column; }
+
+        operator DbColumn()
+        { return _column; }
+
+        Interned& operator=(const QString &value) {
+            _column = value;
+            return *this;
+        }
+
+    private:
+        InternedColumn _column;
+    };
+
     using Int = IntColumn;
     using BigInt = BigIntColumn;
     using String = StringColumn;
 
-#define DECLARE_TABLE(Table) Table(const QString &tableName = abi::__cxa_demangle(typeid(Table).name(),0,0,nullptr), DbContext context = nullptr) : TableModel(tableName, context) {}
-#define COLUMN(name) name = decltype(name)(#name, this)
+/*
+ * Имя типа таблицы (typeName) и имя таблицы (modelName) берутся из имени,
+ * переданного в макрос, во время компиляции, без разбора typeid.
+ * Схема типа таблицы создаётся один раз и разделяется всеми объектами
+ * этого типа. Образец таблицы (tablePrototype) создаётся при первом
+ * обращении и используется как таблица, на которую ссылаются вторичные
+ * ключи: создание объекта записи не создаёт связанных таблиц.
+ * Копия таблицы создаётся как новый объект с собственными колонками,
+ * в которые переносятся значения: указатели на колонки внутри модели
+ * таблицы должны указывать на колонки копии, а не оригинала.
+ */
+#define DECLARE_TABLE(Table) static QString typeName() { return QStringLiteral(#Table); } \
+    static const QString& modelName() { static const QString name = TableSchema::prepareTableName(typeName()); return name; } \
+    static TableSchema& tableSchema() { static TableSchema schema(modelName()); return schema; } \
+    static DbTable tablePrototype() { static Table prototype; return &prototype; } \
+    static const RowLayout& rowLayout() { static const RowLayout layout(*static_cast<Table*>(tablePrototype())); return layout; } \
+    Table(const QString &tableName = typeName(), DbContext context = nullptr) : TableModel(tableName, context, &tableSchema()) { completeSchema(); } \
+    Table(const Table &table) : TableModel(table.getModelName(), nullptr, &tableSchema()) { completeSchema(); assignModel(table); trackAs(table); } \
+    Table(Table &&table) noexcept : TableModel(table.getModelName(), nullptr, &tableSchema()) { completeSchema(); moveModel(table); trackAs(table); } \
+    Table& operator=(const Table &table) { assignModel(table); return *this; } \
+    Table& operator=(Table &&table) noexcept { moveModel(table); return *this; }
+#define COLUMN(name) name = decltype(name)(QStringLiteral(#name), this)
 };
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <QStack>
 #include <QDebug>
 #include <QVariant>
@@ -14,8 +15,16 @@ namespace jara_lib {
         explicit ModelContext(const DbConnection &connection)
             : _connection(connection) { }
 
+        /*
+         * Записи, которые переживают контекст, не должны обращаться
+         * к нему при удалении.
+         */
+        virtual ~ModelContext()
+        { detachAll(); }
+
         /*! Регистрация таблицы, связанной с контекстом (ModelContext) */
         void registerTable(const DbTable &table) override {
+            QWriteLocker locker(&_tablesLock);
             // Находим таблицу с тем же названием среди привязанных к
             // контексту таблиц
             QHash<DbTable, QVector<DbTable>>::iterator _found = _tables.end();
@@ -41,28 +50,496 @@ namespace jara_lib {
         DbType getDbType() const override
         { return _connection.getDbType(); }
 
-        QSqlQuery proceedExpression(
-            const IExpressionHandler &expression) override {
+        /*!
+         *  Составление строки запроса из узлов выражения (ModelContext).
+         *  Пропускаются команды, которые не были заданы в выражении.
+         */
+        QString prepareExpression(
+            const IExpressionHandler &expression) const override {
             const ExpressionNodes &nodes = expression.getExpressionNodes();
 
-            if (nodes.count()) {
-                QString expression = "";
-
-                for (QueryClause clause = QueryClause::SELECT;
-                     clause <= QueryClause::DESC;
-                     clause = QueryClause(ushort(clause) + 1)) {
+            QString command = "";
+            for (QueryClause clause = QueryClause::SELECT;
+                 clause <= QueryClause::DESC;
+                 clause = QueryClause(ushort(clause) + 1)) {
 
-                    expression += _connection.Command->
+                if (nodes.contains(clause)) {
+                    command += _connection.Command->
                         makeExpressionClause(clause, nodes[clause]);
                 }
+            }
 
-                return _connection.proceedQuery(expression.trimmed());
+            return command.trimmed();
+        }
+
+        QSqlQuery proceedExpression(
+            const IExpressionHandler &expression,
+            bool forwardOnly = false) override {
+            if (expression.getExpressionNodes().count()) {
+                return _connection.proceedQuery(
+                    prepareExpression(expression), false, forwardOnly);
             }
 
             return QSqlQuery();
         }
 
+        /*!
+         *  Открытие курсора СУБД для чтения результата частями
+         *  (ModelContext). Курсор живёт внутри транзакции, которая
+         *  завершается при закрытии курсора. Возвращает имя курсора
+         *  или пустую строку, если СУБД читает результат без курсора.
+         */
+        QString openCursor(const IExpressionHandler &expression) override {
+            const QString &cursor =
+                "jara_cursor_" +
+                QString::number(_cursorCount.fetchAndAddOrdered(1) + 1);
+            const QString &command = _connection.Command->
+                declareCursor(cursor, prepareExpression(expression));
+
+            if (command.isEmpty() || !_connection.beginTransaction()) {
+                return "";
+            }
+
+            if (!_connection.proceedQuery(command).isActive()) {
+                _connection.commitTransaction();
+                return "";
+            }
+            return cursor;
+        }
+
+        /*! Чтение следующих записей курсора СУБД (ModelContext) */
+        QSqlQuery fetchCursor(const QString &cursor, int fetchSize) override {
+            return _connection.proceedQuery(_connection.Command->
+                fetchCursor(cursor, fetchSize), false, true);
+        }
+
+        /*! Закрытие курсора СУБД и его транзакции (ModelContext) */
+        void closeCursor(const QString &cursor) override {
+            _connection.proceedQuery(_connection.Command->closeCursor(cursor));
+            _connection.commitTransaction();
+        }
+
+        /*!
+         *  Пакетная вставка записей одной таблицы (ModelContext).
+         *  Записи разбиваются на части по ограничениям СУБД на количество
+         *  параметров, каждая часть вставляется одним запросом, все части -
+         *  в одной транзакции: при ошибке не вставляется ни одна. Значения
+         *  первичного ключа-счётчика возвращаются тем же запросом
+         *  (RETURNING в PostgreSQL, OUTPUT INSERTED в MS SQL Server) или
+         *  вычисляются от LAST_INSERT_ID() для MySQL и записываются
+         *  обратно в колонки объектов без дополнительного SELECT.
+         */
+        bool proceedInsert(const QVector<DbTable> &rows) override {
+            if (rows.isEmpty()) {
+                return true;
+            }
+
+            const DbTable &table = rows.first();
+            // Первичный ключ заполняется СУБД, если он является счётчиком
+            DbColumn keyColumn = table->getPkColumn();
+            if (keyColumn &&
+                keyColumn->getModelType() != ColumnType::INT_SERIAL &&
+                keyColumn->getModelType() != ColumnType::BIGINT_SERIAL) {
+                keyColumn = nullptr;
+            }
+
+            // Ключи из блоков выдаются до вставки, и колонка ключа
+            // передаётся в запрос наравне с остальными
+            for (const DbTable &row : rows) {
+                assignKey(row);
+            }
+
+            // Имена вставляемых колонок берём из первой записи,
+            // у остальных записей колонки ищутся по этим именам
+            QVector<DbColumn> columns;
+            QVector<QString> columnNames;
+            for (const DbColumn &column : as_const(table->getTableColumns())) {
+                if (column != keyColumn) {
+                    columns.append(column);
+                    columnNames.append(column->getModelName());
+                }
+            }
+
+            // Количество записей в одном запросе
+            int chunkSize = qMin(_connection.Command->maxInsertRows(),
+                _connection.Command->maxBoundValues() / qMax(1, columns.count()));
+            chunkSize = qMax(1, chunkSize);
+
+            // Ключи записей, которые не возвращает запрос, вычисляются
+            // по ключу первой записи с шагом ключей-счётчиков СУБД
+            const bool computedKeys = keyColumn &&
+                !_connection.Command->returnsKeyOrdinals() &&
+                !_connection.Command->returnsInsertedKeys();
+            const int keyIncrement =
+                (computedKeys) ? _connection.insertKeyIncrement() : 1;
+            if (keyIncrement <= 0) {
+                return false;
+            }
+
+            // Все части вставляются в одной транзакции, а ключи и состояния
+            // колонок записываются в объекты только после её завершения
+            if (!_connection.beginTransaction()) {
+                return false;
+            }
+
+            QVector<QVariant> keys((keyColumn) ? rows.count() : 0);
+            for (int from = 0; from < rows.count(); from += chunkSize) {
+                int rowCount = qMin(chunkSize, rows.count() - from);
+
+                QVector<QVariant> values;
+                values.reserve(rowCount * columns.count());
+                for (int row = from; row < from + rowCount; ++row) {
+                    for (const QString &columnName : qAsConst(columnNames)) {
+                        DbColumn column = rows[row]->getColumn(columnName);
+                        values.append((column) ? column->getModelValue()
+                                               : QVariant());
+                    }
+                }
+
+                QString command = _connection.Command->
+                    insertRows(table, columns, rowCount, keyColumn);
+                QSqlQuery query = _connection.proceedQuery(command, values);
+                if (!query.isActive()) {
+                    _connection.rollbackTransaction();
+                    return false;
+                }
+
+                if (!keyColumn) {
+                    continue;
+                }
+
+                if (_connection.Command->returnsKeyOrdinals()) {
+                    // Ключ приходит вместе с номером записи в части
+                    while (query.next()) {
+                        const int row = from + query.value(0).toInt();
+                        if (row >= from && row < from + rowCount) {
+                            keys[row] = query.value(1);
+                        }
+                    }
+                }
+                else if (_connection.Command->returnsInsertedKeys()) {
+                    // Ключи приходят набором записей в порядке вставки
+                    int row = from;
+                    while (query.next() && row < from + rowCount) {
+                        keys[row++] = query.value(0);
+                    }
+                }
+                else {
+                    /*
+                     * MySQL для вставки нескольких записей возвращает ключ
+                     * первой из них, ключи остальных идут подряд с шагом
+                     * auto_increment_increment (при innodb_autoinc_lock_mode
+                     * 0 или 1). Если вставлены не все записи, то ключи
+                     * остальных вычислить нельзя.
+                     */
+                    if (query.numRowsAffected() != rowCount) {
+                        _connection.rollbackTransaction();
+                        return false;
+                    }
+
+                    qlonglong firstKey = query.lastInsertId().toLongLong();
+                    for (int row = from; row < from + rowCount; ++row) {
+                        keys[row] = firstKey + (row - from) * keyIncrement;
+                    }
+                }
+            }
+
+            if (!_connection.commitTransaction()) {
+                return false;
+            }
+
+            for (int row = 0; row < rows.count(); ++row) {
+                if (keyColumn) {
+                    rows[row]->getPkColumn()->setModelValue(keys[row]);
+                }
+                acceptChanges(rows[row]);
+            }
+            return true;
+        }
+
+        /*!
+         *  Присвоение записи ключа из зарезервированного блока (ModelContext).
+         *  Ключ присваивается только если первичный ключ таблицы заполняется
+         *  приложением и у записи ещё нет ключа. Так дочерние записи могут
+         *  ссылаться на родительскую до того, как она будет вставлена.
+         */
+        void assignKey(const DbTable &row) override {
+            DbColumn keyColumn = row->getPkColumn();
+            if (keyColumn && keyColumn->getKeyBlockSize() > 0 &&
+                keyColumn->getModelValue().toLongLong() == 0) {
+                keyColumn->setModelValue(generateKey(keyColumn));
+            }
+        }
+
+        /*!
+         *  Пакетное изменение записей (ModelContext). В запросы попадают
+         *  только колонки в состоянии CHANGED, первичный ключ не меняется.
+         *  Записи одной таблицы с одинаковым набором изменённых колонок
+         *  изменяются одним запросом на часть записей (UPDATE ... FROM
+         *  (VALUES ...) или соединение с производной таблицей для MySQL),
+         *  части выбираются по тем же ограничениям СУБД, что и при вставке.
+         *  Все запросы выполняются в одной транзакции; после её
+         *  завершения колонки записей снова считаются неизменёнными.
+         */
+        bool proceedUpdate(const QVector<DbTable> &rows) override {
+            // Ключ группы - имя таблицы и упорядоченные имена колонок
+            QMap<QString, QVector<DbTable>> groups;
+            for (const DbTable &row : rows) {
+                QVector<QString> columnNames;
+                for (const DbColumn &column : changedColumns(row)) {
+                    columnNames.append(column->getModelName());
+                }
+                if (columnNames.isEmpty()) {
+                    continue;
+                }
+
+                std::sort(columnNames.begin(), columnNames.end());
+                QString group = row->getModelName();
+                for (const QString &columnName : qAsConst(columnNames)) {
+                    group += "," + columnName;
+                }
+                groups[group].append(row);
+            }
+
+            if (groups.isEmpty()) {
+                return true;
+            }
+            if (!_connection.beginTransaction()) {
+                return false;
+            }
+
+            for (const QVector<DbTable> &group : qAsConst(groups)) {
+                if (!updateRows(group)) {
+                    _connection.rollbackTransaction();
+                    return false;
+                }
+            }
+            if (!_connection.commitTransaction()) {
+                return false;
+            }
+
+            for (const QVector<DbTable> &group : qAsConst(groups)) {
+                for (const DbTable &row : group) {
+                    acceptChanges(row);
+                }
+            }
+            return true;
+        }
+
+        /*!
+         *  Добавление записи в отслеживаемые контекстом (ModelContext).
+         *  Запись помнит контекст и удаляется из отслеживаемых вместе
+         *  с объектом (~TableModel).
+         */
+        void attach(const DbTable &row) override {
+            QMutexLocker locker(&_attachedRowsLock);
+            _attachedRows.insert(row);
+            static_cast<TableModel*>(row)->setTrackingContext(this);
+        }
+
+        /*! Удаление записи из отслеживаемых контекстом (ModelContext) */
+        void detach(const DbTable &row) override {
+            QMutexLocker locker(&_attachedRowsLock);
+            if (_attachedRows.remove(row)) {
+                static_cast<TableModel*>(row)->setTrackingContext(nullptr);
+            }
+        }
+
+        /*!
+         *  Сохранение изменений всех отслеживаемых записей (ModelContext).
+         *  Записи остаются отслеживаемыми, следующий вызов сохранит
+         *  только изменения, сделанные после этого.
+         */
+        bool saveChanges() {
+            QVector<DbTable> rows;
+            {
+                QMutexLocker locker(&_attachedRowsLock);
+                rows.reserve(_attachedRows.count());
+                for (const DbTable &row : _attachedRows) {
+                    rows.append(row);
+                }
+            }
+            return proceedUpdate(rows);
+        }
+
+        /*! Прекращение отслеживания всех записей (ModelContext) */
+        void detachAll() {
+            QMutexLocker locker(&_attachedRowsLock);
+            for (const DbTable &row : _attachedRows) {
+                static_cast<TableModel*>(row)->setTrackingContext(nullptr);
+            }
+            _attachedRows.clear();
+        }
+
+        /*!
+         *  Запись, уже загруженная в контекст, по имени таблицы и значению
+         *  первичного ключа (ModelContext), или пустой указатель.
+         */
+        QSharedPointer<ITableModel> findRow(const QString &tableName,
+                                            qlonglong key) const override {
+            QReadLocker locker(&_loadedRowsLock);
+            return _loadedRows.value(tableName).value(key);
+        }
+
+        /*!
+         *  Добавление загруженной записи в карту записей контекста
+         *  (ModelContext). Если запись с тем же ключом уже есть, то
+         *  возвращается она, и все загрузки получают один объект записи.
+         */
+        QSharedPointer<ITableModel> registerRow(
+                const QSharedPointer<ITableModel> &row) override {
+            const DbColumn keyColumn = row->getPkColumn();
+            if (!keyColumn) {
+                return row;
+            }
+
+            QWriteLocker locker(&_loadedRowsLock);
+            QSharedPointer<ITableModel> &loaded =
+                _loadedRows[row->getModelName()][
+                    keyColumn->getModelValue().toLongLong()];
+            if (!loaded) {
+                loaded = row;
+            }
+            return loaded;
+        }
+
+        /*!
+         *  Запись таблицы по значению первичного ключа (ModelContext):
+         *  context.find<DepartmentTable>(id). Запись, уже загруженная в
+         *  контекст (find, include, загрузка по вторичному ключу), берётся
+         *  из карты записей без запроса к базе, иначе загружается и
+         *  добавляется в карту. Пустой указатель, если записи нет.
+         */
+        template <class Table>
+        QSharedPointer<Table> find(qlonglong key) {
+            QSharedPointer<ITableModel> row = findRow(Table::modelName(), key);
+            if (!row) {
+                row = ExpressionHandler::loadRows<Table>(
+                    this, QVector<QVariant>() << key, 1).value(key);
+            }
+            return qSharedPointerCast<Table>(row);
+        }
+
+        /*!
+         *  Удаление записей из карты записей контекста (ModelContext),
+         *  например, если записи изменены в базе в обход контекста.
+         */
+        void clearLoadedRows() {
+            QWriteLocker locker(&_loadedRowsLock);
+            _loadedRows.clear();
+        }
+
     private:
+        /*! Изменённые колонки записи, кроме первичного ключа (ModelContext) */
+        QVector<DbColumn> changedColumns(const DbTable &row) const {
+            const DbColumn keyColumn = row->getPkColumn();
+            QVector<DbColumn> columns;
+            if (!keyColumn) {
+                return columns;
+            }
+
+            for (const DbColumn &column : as_const(row->getTableColumns())) {
+                if (column != keyColumn &&
+                    column->getValueState() == ValueState::CHANGED) {
+                    columns.append(column);
+                }
+            }
+            return columns;
+        }
+
+        /*!
+         *  Изменение записей с одинаковым набором изменённых колонок
+         *  (ModelContext). Колонки берутся из первой записи, у остальных
+         *  записей они ищутся по именам.
+         */
+        bool updateRows(const QVector<DbTable> &rows) {
+            const DbTable &table = rows.first();
+            const DbColumn keyColumn = table->getPkColumn();
+            const QVector<DbColumn> &columns = changedColumns(table);
+
+            int chunkSize = qMin(_connection.Command->maxInsertRows(),
+                _connection.Command->maxBoundValues() / (columns.count() + 1));
+            chunkSize = qMax(1, chunkSize);
+
+            for (int from = 0; from < rows.count(); from += chunkSize) {
+                int rowCount = qMin(chunkSize, rows.count() - from);
+
+                QVector<QVariant> values;
+                values.reserve(rowCount * (columns.count() + 1));
+                for (int row = from; row < from + rowCount; ++row) {
+                    values.append(rows[row]->getPkColumn()->getModelValue());
+                    for (const DbColumn &column : columns) {
+                        values.append(rows[row]->
+                            getColumn(column->getModelName())->getModelValue());
+                    }
+                }
+
+                QString command = _connection.Command->
+                    updateRows(table, keyColumn, columns, rowCount);
+                if (!_connection.proceedQuery(command, values).isActive()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*!
+         *  Значения записи совпадают с сохранёнными в базе (ModelContext):
+         *  изменённые колонки снова считаются неизменёнными.
+         */
+        void acceptChanges(const DbTable &row) {
+            for (const DbColumn &column : as_const(row->getTableColumns())) {
+                if (column->getValueState() == ValueState::CHANGED) {
+                    column->setValueState(ValueState::ADDED);
+                }
+            }
+        }
+
+        /*! Таблицы, связанные с контекстом (ModelContext) */
+        QList<DbTable> getTables() const {
+            QReadLocker locker(&_tablesLock);
+            return _tables.keys();
+        }
+
+        /*!
+         *  Выдача следующего ключа из блока (ModelContext). Когда блок
+         *  исчерпан, в СУБД одним обращением резервируется следующий.
+         */
+        qlonglong generateKey(const DbColumn &keyColumn) {
+            QMutexLocker locker(&_keyBlocksLock);
+            QPair<qlonglong, qlonglong> &block =
+                _keyBlocks[keyColumn->getTable()->getModelName()];
+
+            if (block.first >= block.second) {
+                const int blockSize = keyColumn->getKeyBlockSize();
+                const QVector<QString> &commands =
+                    _connection.Command->reserveKeys(keyColumn, blockSize);
+
+                // Резервирование из нескольких запросов не должно
+                // перемежаться с резервированием из других подключений
+                const bool transaction = commands.count() > 1 &&
+                                         _connection.beginTransaction();
+                QSqlQuery query;
+                for (const QString &command : commands) {
+                    query = _connection.proceedQuery(command);
+                }
+                const bool reserved = query.first();
+                if (transaction) {
+                    _connection.commitTransaction();
+                }
+
+                if (!reserved) {
+                    throw "Couldn\'t reserve keys for the table " +
+                        keyColumn->getTable()->getModelName();
+                }
+
+                block.first = query.value(0).toLongLong();
+                block.second = block.first + blockSize;
+            }
+
+            return block.first++;
+        }
+
         /*! Метод проверки существования базы данных (ModelContext) */
         bool databaseExists() {
             // Создаем строку запроса для проверки существования
@@ -237,11 +714,34 @@ namespace jara_lib {
 
         /*! Метод для создания таблиц (ModelContext) */
         void createTable(DbTable table) {
+            QSet<QString> creating;
+            QString constraints;
+            createTable(table, creating, constraints);
+
+            // Вторичные ключи на таблицы, которые создавались в это же
+            // время, добавляются после создания всех таблиц
+            if (!constraints.isEmpty()) {
+                _connection.proceedQuery(constraints);
+            }
+        }
+
+        /*
+         * Создание таблицы вместе с таблицами, на которые ссылаются её
+         * вторичные ключи (ModelContext). В creating - имена таблиц,
+         * создание которых уже начато: по ним рекурсия не идёт, иначе
+         * ключ таблицы на саму себя или цикл ссылок между таблицами
+         * приводит к бесконечной рекурсии. Ключи на такие таблицы
+         * откладываются в constraints.
+         */
+        void createTable(DbTable table, QSet<QString> &creating,
+                         QString &constraints) {
             /* Проверяем существует ли данная таблица в базе */
-            if (tableExists(table)) {
+            if (creating.contains(table->getModelName()) ||
+                tableExists(table)) {
                 // Если существует, то ничего не делаем
                 return;
             }
+            creating.insert(table->getModelName());
 
             const QString &dbName = _connection.getDbName();
             // Создаем текстовый запрос на создание таблица
@@ -251,6 +751,17 @@ namespace jara_lib {
             // Проходим по коллекции вторичных ключей данной таблицы
             for (const QPair<DbTable, DbColumn> &item :
                  as_const(table->getFkColumns())) {
+                const QString &constraint =
+                    _connection.Command->alterAddConstraint(
+                        dbName, item.second, item.first->getPkColumn());
+
+                // Таблица, создание которой уже начато, ещё может
+                // не существовать в базе
+                if (creating.contains(item.first->getModelName())) {
+                    constraints += constraint;
+                    continue;
+                }
+
                 /*
                  * Таблица со связанным вторичным ключом не может быть создана,
                  * пока не создана таблица, с которым связан вторичный ключ.
@@ -259,16 +770,28 @@ namespace jara_lib {
                  * с другими таблицами.
                  */
                 // Создаём связанную таблицу, если она ещё не создана
-                createTable(item.first);
+                createTable(item.first, creating, constraints);
                 // Добавляем подстроку для создачния записи о вторичном ключе
-                command += _connection.Command->alterAddConstraint(
-                    dbName, item.second, item.first->getPkColumn());
+                command += constraint;
             }
 
+            // Добавляем хранилище блоков ключей, если ключи выдаёт приложение
+            command += createKeySequence(table);
+
             // Выполняем запрос на создание таблицы
             _connection.proceedQuery(command);
         }
 
+        /*! Строка запроса для создания хранилища блоков ключей (ModelContext) */
+        QString createKeySequence(const DbTable &table) const {
+            DbColumn keyColumn = table->getPkColumn();
+            if (keyColumn && keyColumn->getKeyBlockSize() > 0) {
+                return _connection.Command->createKeySequence(
+                    keyColumn, keyColumn->getKeyBlockSize());
+            }
+            return "";
+        }
+
     public:
         /*!
          *  Метод для приведения структуры базы приложения в соответствие с тем,
@@ -288,7 +811,7 @@ namespace jara_lib {
             // Название базы приложений
             const QString &dbName = _connection.getDbName();
 
-            const QList<DbTable> &tables = _tables.keys();
+            const QList<DbTable> &tables = getTables();
             // Проходим по коллекции таблиц контекста
             for (const DbTable &table : qAsConst(tables)) {
                 // Проверяем существует ли таблица в базе
@@ -320,6 +843,10 @@ namespace jara_lib {
                     command += _connection.Command->createTable(dbName, table);
                 }
 
+                // Хранилище блоков ключей создаётся, если его ещё нет, и
+                // согласуется с размером блока и ключами таблицы
+                command += createKeySequence(table);
+
                 // Проходим по коллекции вторичных ключей для текущей таблицы
                 for (const QPair<DbTable, DbColumn> &item :
                      as_const(table->getFkColumns())) {
@@ -363,7 +890,7 @@ namespace jara_lib {
                     qDebug() << "The database" << _connection.getDbName()
                              << "is created";
                     // затем проходим по коллекции таблиц
-                    const QList<DbTable> &tables = _tables.keys();
+                    const QList<DbTable> &tables = getTables();
                     for (const DbTable &table : qAsConst(tables)) {
                         // и создаём их в базе
                         createTable(table);
@@ -389,8 +916,34 @@ namespace jara_lib {
          */
         /*! Коллекция таблиц, связанных с контекстом (ModelContext) */
         QHash<DbTable, QVector<DbTable>> _tables;
+        /*! Блокировка коллекции таблиц контекста (ModelContext) */
+        mutable QReadWriteLock _tablesLock;
 
         /*! Объект подключения к базе данных (ModelContext) */
         DbConnection _connection;
+
+        /*!
+         *  Зарезервированные блоки ключей по именам таблиц (ModelContext):
+         *  первое значение - следующий ключ, второе - граница блока
+         */
+        QHash<QString, QPair<qlonglong, qlonglong>> _keyBlocks;
+        /*! Блокировка блоков ключей (ModelContext) */
+        QMutex _keyBlocksLock;
+
+        /*! Счётчик для имён курсоров СУБД (ModelContext) */
+        QAtomicInt _cursorCount;
+
+        /*! Записи, изменения которых сохраняет saveChanges (ModelContext) */
+        QSet<DbTable> _attachedRows;
+        /*! Блокировка коллекции отслеживаемых записей (ModelContext) */
+        QMutex _attachedRowsLock;
+
+        /*!
+         *  Карта загруженных записей (identity map): записи по именам
+         *  таблиц и значениям первичного ключа (ModelContext)
+         */
+        QHash<QString, QHash<qlonglong, QSharedPointer<ITableModel>>> _loadedRows;
+        /*! Блокировка карты загруженных записей (ModelContext) */
+        mutable QReadWriteLock _loadedRowsLock;
     };
 };
@@ -1,11 +1,16 @@
 DEFINES += JARA_LIB_LIBRARY
 
 HEADERS += \
+    $$PWD/column_batch.h \
     $$PWD/column_expression.h \
     $$PWD/column_model.h \
     $$PWD/column_types.h \
     $$PWD/model_context.h \
+    $$PWD/row_set.h \
+    $$PWD/table_schema.h \
     $$PWD/table_model.h
 
 SOURCES += \
-    $$PWD/column_expression.cpp
+    $$PWD/column_batch.cpp \
+    $$PWD/column_expression.cpp \
+    $$PWD/row_set.cpp
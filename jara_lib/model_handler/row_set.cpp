@@ -0,0 +1,188 @@
+#include <cstring>
+#include "row_set.h"
+#include "table_model.h"
+#include "db_handler/db_record_cursor.h"
+
+namespace jara_lib {
+    namespace {
+        int valueSize(ColumnType type) {
+            switch (type) {
+                case ColumnType::INT:
+                case ColumnType::INT_NULL:
+                case ColumnType::INT_SERIAL:
+                    return sizeof(qint32);
+                default:
+                    // BIGINT или смещение и длина строки
+                    return sizeof(qint64);
+            }
+        }
+
+        template <typename Value>
+        Value readValue(const char *data) {
+            Value value;
+            std::memcpy(&value, data, sizeof(Value));
+            return value;
+        }
+
+        template <typename Value>
+        void writeValue(char *data, Value value)
+        { std::memcpy(data, &value, sizeof(Value)); }
+    }
+
+    RowLayout::RowLayout(const TableModel &table) {
+        const int columnCount = table.getColumnCount();
+        _slots.reserve(columnCount);
+
+        const int bitmapSize = (columnCount + 7) / 8;
+        int offset = bitmapSize;
+        for (int ordinal = 0; ordinal < columnCount; ++ordinal) {
+            if (table.getColumn(ordinal)->isDeferred()) {
+                _unloadedOffset = bitmapSize;
+                offset += bitmapSize;
+                break;
+            }
+        }
+
+        for (int ordinal = 0; ordinal < columnCount; ++ordinal) {
+            const DbColumn column = table.getColumn(ordinal);
+
+            Slot slot;
+            slot.name = column->getModelName();
+            slot.type = column->getModelType();
+            slot.deferred = column->isDeferred();
+            const int size = valueSize(slot.type);
+            slot.offset = (offset + size - 1) / size * size;
+            offset = slot.offset + size;
+
+            _ordinals.insert(slot.name, ordinal);
+            _slots.append(slot);
+        }
+        _rowSize = (offset + 7) / 8 * 8;
+    }
+
+    bool RowSet::Row::isLoaded(int ordinal) const {
+        const int offset = _rows->_layout->unloadedOffset();
+        return offset < 0 ||
+               !(_data[offset + (ordinal >> 3)] & (1 << (ordinal & 7)));
+    }
+
+    qint32 RowSet::Row::toInt(int ordinal) const
+    { return readValue<qint32>(_data + _rows->_layout->slot(ordinal).offset); }
+
+    qint64 RowSet::Row::toLongLong(int ordinal) const
+    { return readValue<qint64>(_data + _rows->_layout->slot(ordinal).offset); }
+
+    QString RowSet::Row::toString(int ordinal) const {
+        const char *data = _data + _rows->_layout->slot(ordinal).offset;
+        return QString::fromUtf8(
+            _rows->_strings.constData() + readValue<qint32>(data),
+            readValue<qint32>(data + sizeof(qint32)));
+    }
+
+    QVariant RowSet::Row::value(int ordinal) const {
+        if (isNull(ordinal)) {
+            return QVariant();
+        }
+
+        switch (_rows->_layout->slot(ordinal).type) {
+            case ColumnType::INT:
+            case ColumnType::INT_NULL:
+            case ColumnType::INT_SERIAL:
+                return toInt(ordinal);
+            case ColumnType::BIGINT:
+            case ColumnType::BIGINT_NULL:
+            case ColumnType::BIGINT_SERIAL:
+                return toLongLong(ordinal);
+            default:
+                return toString(ordinal);
+        }
+    }
+
+    QVariant RowSet::Row::value(const QString &name) const {
+        const int ordinal = _rows->_layout->columnOrdinal(name);
+        return (ordinal >= 0) ? value(ordinal) : QVariant();
+    }
+
+    void RowSet::reserve(int rowCount)
+    { _rows.reserve(rowCount * _layout->rowSize()); }
+
+    void RowSet::squeeze() {
+        _rows.squeeze();
+        _strings.squeeze();
+    }
+
+    char* RowSet::appendRow() {
+        const int rowSize = _layout->rowSize();
+        _rows.resize((_rowCount + 1) * rowSize);
+        char *data = _rows.data() + _rowCount * rowSize;
+        std::memset(data, 0, rowSize);
+        // Пока значение не записано, колонка отмечена как NULL
+        std::memset(data, 0xFF, (_layout->columnCount() + 7) / 8);
+        ++_rowCount;
+        return data;
+    }
+
+    void RowSet::setUnloaded(char *data, int ordinal) {
+        data[_layout->unloadedOffset() + (ordinal >> 3)] |=
+            char(1 << (ordinal & 7));
+    }
+
+    void RowSet::setValue(char *data, int ordinal, const QVariant &value) {
+        if (value.isNull()) {
+            return;
+        }
+        data[ordinal >> 3] &= char(~(1 << (ordinal & 7)));
+
+        const RowLayout::Slot &slot = _layout->slot(ordinal);
+        switch (slot.type) {
+            case ColumnType::INT:
+            case ColumnType::INT_NULL:
+            case ColumnType::INT_SERIAL:
+                writeValue<qint32>(data + slot.offset, value.toInt());
+                break;
+            case ColumnType::BIGINT:
+            case ColumnType::BIGINT_NULL:
+            case ColumnType::BIGINT_SERIAL:
+                writeValue<qint64>(data + slot.offset, value.toLongLong());
+                break;
+            default: {
+                const QByteArray &bytes = value.toString().toUtf8();
+                writeValue<qint32>(data + slot.offset, _strings.size());
+                writeValue<qint32>(data + slot.offset + sizeof(qint32),
+                                   bytes.size());
+                _strings.append(bytes);
+            }
+        }
+    }
+
+    void RowSet::append(const RecordCursor &records,
+                        const QVector<int> &ordinals) {
+        char *data = appendRow();
+        for (int index = 0; index < ordinals.count(); ++index) {
+            if (ordinals[index] >= 0) {
+                setValue(data, ordinals[index], records.value(index));
+            }
+        }
+
+        if (_layout->unloadedOffset() < 0) {
+            return;
+        }
+        for (int ordinal = 0; ordinal < _layout->columnCount(); ++ordinal) {
+            if (_layout->slot(ordinal).deferred && !ordinals.contains(ordinal)) {
+                setUnloaded(data, ordinal);
+            }
+        }
+    }
+
+    void RowSet::append(const TableModel &table) {
+        char *data = appendRow();
+        for (int ordinal = 0; ordinal < _layout->columnCount(); ++ordinal) {
+            const DbColumn column = table.getColumn(ordinal);
+            if (!column->isLoaded()) {
+                setUnloaded(data, ordinal);
+                continue;
+            }
+            setValue(data, ordinal, column->getModelValue());
+        }
+    }
+};
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <QByteArray>
+#include "db_handler/db_model_interface.h"
+
+namespace jara_lib {
+    class RecordCursor;
+    class TableModel;
+
+    /*!
+     *  Раскладка записи таблицы в непрерывном буфере.
+     *  Запись начинается с битовой карты отсутствующих значений (бит на
+     *  колонку, бит установлен - значение NULL). У таблицы с отложенными
+     *  колонками за ней идёт такая же карта незагруженных значений: так
+     *  не выбранная отложенная колонка отличается от колонки со значением
+     *  NULL. Далее в порядке объявления колонок идут значения: int32
+     *  для INT, int64 для BIGINT, для строк - смещение и длина (два
+     *  int32) в общем буфере байт набора записей. Значения выровнены
+     *  по своему размеру, размер
+     *  записи кратен 8. Раскладка вычисляется один раз на тип таблицы
+     *  (rowLayout() в DECLARE_TABLE).
+     */
+    class RowLayout {
+    public:
+        /*! Место значения колонки в записи (RowLayout) */
+        struct Slot {
+            QString name;
+            ColumnType type;
+            int offset;
+            bool deferred;
+        };
+
+    public:
+        /*! Раскладка по колонкам таблицы в порядке их объявления */
+        explicit RowLayout(const TableModel &table);
+
+        int rowSize() const
+        { return _rowSize; }
+
+        int columnCount() const
+        { return _slots.count(); }
+
+        const Slot& slot(int ordinal) const
+        { return _slots[ordinal]; }
+
+        /*! Номер колонки по имени, -1 если колонки нет */
+        int columnOrdinal(const QString &name) const
+        { return _ordinals.value(name, -1); }
+
+        /*! Смещение карты незагруженных значений, -1 если её нет */
+        int unloadedOffset() const
+        { return _unloadedOffset; }
+
+    private:
+        QVector<Slot> _slots;
+        QHash<QString, int> _ordinals;
+        int _rowSize = 0;
+        int _unloadedOffset = -1;
+    };
+
+    /*!
+     *  Набор записей одного типа таблицы в непрерывной памяти.
+     *  Запись занимает rowSize() байт раскладки и байты своих строк
+     *  в UTF-8, без объектов колонок, имён и состояний значений.
+     *  Поэтому кэш из миллионов записей занимает долю памяти списка
+     *  объектов таблиц. Значения читаются через Row по номеру колонки
+     *  (смещение берётся из раскладки), объект таблицы создаётся
+     *  только по запросу (toObject).
+     */
+    class RowSet {
+    public:
+        /*! Значения одной записи набора (RowSet) */
+        class Row {
+        public:
+            bool isNull(int ordinal) const
+            { return _data[ordinal >> 3] & (1 << (ordinal & 7)); }
+
+            /*! Значение отложенной колонки выбрано в запросе (Row) */
+            bool isLoaded(int ordinal) const;
+
+            qint32 toInt(int ordinal) const;
+            qint64 toLongLong(int ordinal) const;
+            QString toString(int ordinal) const;
+
+            /*! Значение колонки, пустой QVariant для NULL (Row) */
+            QVariant value(int ordinal) const;
+            QVariant value(const QString &name) const;
+
+        private:
+            friend class RowSet;
+            Row(const RowSet *rows, const char *data)
+                : _rows(rows), _data(data) {}
+
+            const RowSet *_rows;
+            const char *_data;
+        };
+
+    public:
+        explicit RowSet(const RowLayout &layout)
+            : _layout(&layout) {}
+
+        const RowLayout& layout() const
+        { return *_layout; }
+
+        int rowCount() const
+        { return _rowCount; }
+
+        Row row(int index) const
+        { return Row(this, _rows.constData() + index * _layout->rowSize()); }
+
+        Row operator[](int index) const
+        { return row(index); }
+
+        /*! Резервирование памяти под заданное число записей */
+        void reserve(int rowCount);
+
+        /*! Освобождение неиспользуемой памяти после заполнения набора */
+        void squeeze();
+
+        /*!
+         *  Добавление текущей записи курсора (RowSet): значение записи
+         *  с номером index пишется в колонку ordinals[index], значения
+         *  с номером -1 пропускаются, не выбранные колонки остаются NULL,
+         *  а не выбранные отложенные колонки - незагруженными.
+         */
+        void append(const RecordCursor &records, const QVector<int> &ordinals);
+
+        /*!
+         *  Добавление значений объекта таблицы того же типа (RowSet).
+         *  Незагруженное значение отложенной колонки остаётся
+         *  незагруженным, а не записывается как NULL.
+         */
+        void append(const TableModel &table);
+
+        /*!
+         *  Объект таблицы по записи набора: значения записываются в
+         *  колонки теми же функциями, что и при чтении результата запроса.
+         *  Незагруженные отложенные колонки не заполняются и загружаются
+         *  при обращении, если задан контекст.
+         */
+        template <class Table>
+        Table toObject(int index, DbContext context = nullptr) const {
+            Table table(Table::typeName(), nullptr);
+            if (context) {
+                table.registerContext(context);
+            }
+
+            const Row record = row(index);
+            for (int ordinal = 0; ordinal < _layout->columnCount(); ++ordinal) {
+                const DbColumn column = table.getColumn(ordinal);
+                if (!record.isLoaded(ordinal)) {
+                    column->setLoaded(false);
+                    continue;
+                }
+                column->getDecoder()(column, record.value(ordinal));
+            }
+            return table;
+        }
+
+    private:
+        char* appendRow();
+        void setUnloaded(char *data, int ordinal);
+        void setValue(char *data, int ordinal, const QVariant &value);
+
+    private:
+        const RowLayout *_layout;
+        QByteArray _rows;
+        QByteArray _strings;
+        int _rowCount = 0;
+    };
+};
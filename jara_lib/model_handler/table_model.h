@@ -1,8 +1,8 @@
 #pragma once
 
 #include <map>
-#include <cxxabi.h>
 #include "column_expression.h"
+#include "table_schema.h"
 #include "db_handler/db_model_interface.h"
 
 namespace jara_lib {
@@ -11,45 +11,78 @@ namespace jara_lib {
     class TableModel :
         public ITableModel, public ExpressionHandler {
     public:
+        /*
+         * Таблица без схемы типа (например, вспомогательная таблица
+         * для запроса) получает собственную схему.
+         */
         explicit TableModel(const QString &tableName)
-        { setTableName(tableName); }
+            : TableModel(tableName, nullptr, nullptr) {}
 
         explicit TableModel(const QString &tableName,
-                            DbContext context)
-            : TableModel(tableName) {
+                            DbContext context,
+                            TableSchema *schema = nullptr) {
+            if (!schema) {
+                _ownSchema = QSharedPointer<TableSchema>::create(tableName);
+                schema = _ownSchema.data();
+            }
+            _schema = schema;
+            _tableName = _schema->getTableName(tableName);
+            _columnList.reserve(_schema->getColumnCount());
+
             if (context) {
                 context->registerTable(this);
                 setQueryTable(static_cast<DbTable>(this));
             }
         }
 
+        /*
+         * Запись, изменения которой отслеживает контекст, удаляется
+         * из отслеживаемых вместе с объектом.
+         */
         virtual ~TableModel() {
-            if (_tableName) {
-                _register_tables_[*_tableName].remove(this);
-                if (_register_tables_[*_tableName].count() == 0) {
-                    _register_tables_.erase(*_tableName);
-                }
+            if (_trackingContext) {
+                _trackingContext->detach(this);
             }
         }
 
-        void setTableName(const QString &tableName) {
-            QString tbName = tableName;
-            if (tbName.contains("Table")) {
-                tbName.replace("Table", "");
-            }
+        /*!
+         *  Контекст, который отслеживает изменения записи (TableModel).
+         *  Задаётся контекстом при добавлении записи в отслеживаемые
+         *  и сбрасывается при её удалении оттуда.
+         */
+        void setTrackingContext(DbContext context)
+        { _trackingContext = context; }
 
-            if (_tableName) {
-                *_tableName = tbName;
-            }
-            else {
-                _register_tables_[tbName].insert(this);
-                TableRegister::iterator reg = _register_tables_.find(tbName);
-                _tableName = const_cast<QString*>(&reg->first);
-            }
-        }
+        DbContext getTrackingContext() const
+        { return _trackingContext; }
+
+        /*!
+         *  Переименование таблицы (TableModel). Меняется только имя
+         *  данного объекта, схема типа таблицы остаётся прежней.
+         */
+        void setTableName(const QString &tableName)
+        { _tableName = TableSchema::prepareTableName(tableName); }
 
         QString getTableName() const
-        { return (_tableName) ? *_tableName : ""; }
+        { return _tableName; }
+
+        /*!
+         *  Имя очередной колонки из схемы типа таблицы (TableModel).
+         *  Колонка уже зарегистрирована, её номер - последний в таблице.
+         */
+        QString getSchemaColumnName(const QString &columnName) const
+        { return _schema->getColumnName(_columnList.count() - 1, columnName); }
+
+        /*! Имя колонки с номером ordinal из схемы типа таблицы (TableModel) */
+        QString getSchemaColumnName(int ordinal) const
+        { return _schema->getColumnName(ordinal); }
+
+        void setSchemaColumnName(int ordinal, const QString &columnName)
+        { _schema->setColumnName(ordinal, columnName); }
+
+        /*! Все колонки объекта созданы, схема типа заполнена (TableModel) */
+        void completeSchema()
+        { _schema->complete(); }
 
         QString getModelName() const override
         { return getTableName(); }
@@ -57,11 +90,19 @@ namespace jara_lib {
         void setModelName(const QString &tableName) override
         { setTableName(tableName); }
 
-        void registerModel(DbColumn column) override
-        { _tableColumns.insert(column); }
+        /*
+         * Колонки регистрируются инициализаторами членов структуры
+         * таблицы, каждая ровно один раз, поэтому повторная регистрация
+         * проверяется только в отладочной сборке.
+         */
+        void registerModel(DbColumn column) override {
+            Q_ASSERT(!_columnList.contains(column));
+            _columnList.append(column);
+        }
 
-        DbColumns getTableColumns() const override
-        { return _tableColumns; }
+        /*! Колонки в порядке объявления в структуре таблицы (TableModel) */
+        const DbColumns& getTableColumns() const override
+        { return _columnList; }
 
         void registerContext(DbContext context) override {
             if (!_tableContext) {
@@ -72,17 +113,220 @@ namespace jara_lib {
         DbContext getTableContext() const override
         { return _tableContext; }
 
-        DbColumn operator[](QString columnName) {
-            columnName = columnName.replace("\"", "");
-            const QString &clName = (columnName.contains(*_tableName + "."))
-                ? columnName.mid(columnName.indexOf('.') + 1)
-                : columnName;
-            for (DbColumn column : as_const(getTableColumns())) {
-                if (column->getModelName() == clName) {
-                    return column;
+        /*!
+         *  Порядковый номер колонки в таблице по её имени (TableModel).
+         *  Имя может быть указано вместе с именем таблицы, в том числе
+         *  в кавычках, как в списке выбираемых колонок запроса.
+         *  Колонки нумеруются в порядке объявления в структуре таблицы,
+         *  поэтому номер одинаков для всех объектов одного типа таблицы
+         *  и берётся из хеша имён схемы типа. Поиск по имени колонки
+         *  без имени таблицы не выделяет память.
+         */
+        int getColumnOrdinal(const QString &name) const {
+            const int ordinal = _schema->getColumnOrdinal(name);
+            if (ordinal >= 0 || !name.contains('.')) {
+                return ordinal;
+            }
+
+            QString columnName = name;
+            columnName.remove('"');
+            if (!columnName.startsWith(_tableName + ".")) {
+                return -1;
+            }
+            return _schema->getColumnOrdinal(
+                columnName.mid(_tableName.size() + 1));
+        }
+
+        /*! Колонка по её порядковому номеру в таблице (TableModel) */
+        DbColumn getColumn(int ordinal) const
+        { return _columnList[ordinal]; }
+
+        int getColumnCount() const
+        { return _columnList.count(); }
+
+        DbColumn getColumn(const QString &name) const override {
+            int ordinal = getColumnOrdinal(name);
+            return (ordinal >= 0) ? _columnList[ordinal] : nullptr;
+        }
+
+        DbColumn operator[](const QString &columnName)
+        { return getColumn(columnName); }
+
+        /*!
+         *  Копирование значений и их состояний из таблицы того же типа
+         *  (TableModel). Колонки сопоставляются по порядковым номерам,
+         *  значения копируются колонками без преобразования в QVariant.
+         *  Связанные объекты записей не копируются, а разделяются.
+         */
+        void assignModel(const TableModel &table) {
+            registerContext(table.getTableContext());
+            for (int ordinal = 0; ordinal < _columnList.count() &&
+                 ordinal < table._columnList.count(); ++ordinal) {
+                _columnList[ordinal]->copyValue(table._columnList[ordinal]);
+            }
+        }
+
+        /*!
+         *  Перенос значений из таблицы того же типа (TableModel): строки
+         *  и связанные записи не копируются, а переходят в эту таблицу.
+         */
+        void moveModel(TableModel &table) {
+            registerContext(table.getTableContext());
+            for (int ordinal = 0; ordinal < _columnList.count() &&
+                 ordinal < table._columnList.count(); ++ordinal) {
+                _columnList[ordinal]->moveValue(table._columnList[ordinal]);
+            }
+        }
+
+        /*!
+         *  Копия отслеживаемой записи тоже отслеживается (TableModel).
+         *  Так записи остаются отслеживаемыми, когда QVector копирует их
+         *  в новую память и удаляет прежние объекты.
+         */
+        void trackAs(const TableModel &table) {
+            if (table._trackingContext) {
+                table._trackingContext->attach(this);
+            }
+        }
+
+        /*!
+         *  Сброс значений колонок к значениям по умолчанию и состояний
+         *  к UNCHANGED (TableModel). Используется для повторного
+         *  заполнения того же объекта следующей записью результата.
+         */
+        void resetValues() {
+            for (const DbColumn column : _columnList) {
+                column->setModelValue(QVariant());
+                column->setValueState(ValueState::UNCHANGED);
+                column->setLoaded(true);
+                column->setReference(nullptr);
+                column->setReferenceGroup(nullptr);
+            }
+        }
+
+        /*!
+         *  Загрузка значений колонки для записей с заданными значениями
+         *  первичного ключа запросами WHERE Id IN (...) по chunkSize
+         *  значений (TableModel). Возвращает значения по первичному ключу.
+         */
+        QHash<qlonglong, QVariant> loadColumnValues(
+                DbColumn column, const QVector<QVariant> &keys,
+                int chunkSize = 1000) {
+            QHash<qlonglong, QVariant> values;
+            if (!_tableContext) {
+                return values;
+            }
+
+            for (int offset = 0; offset < keys.count(); offset += chunkSize) {
+                TableModel loader(getModelName());
+                loader.registerContext(_tableContext);
+                loader.setQueryTable(static_cast<DbTable>(&loader));
+
+                COL keyColumn(_pkColumn);
+                loader.select(COL(_pkColumn), COL(column))
+                      .where(keyColumn.in(keys.mid(offset, chunkSize)));
+                for (const std::tuple<qlonglong, QVariant> &row :
+                     loader.project<std::tuple<qlonglong, QVariant>>()) {
+                    values[std::get<0>(row)] = std::get<1>(row);
                 }
             }
-            return nullptr;
+            return values;
+        }
+
+        /*!
+         *  Вставка записей в таблицу одним запросом (TableModel).
+         *  После вставки значения сгенерированных первичных ключей
+         *  записываются обратно в колонки объектов.
+         */
+        template <class Table>
+        bool insert(QVector<Table> &rows) {
+            if (!_tableContext) {
+                return false;
+            }
+
+            QVector<DbTable> tables;
+            tables.reserve(rows.count());
+            for (Table &row : rows) {
+                tables.append(static_cast<DbTable>(&row));
+            }
+            return _tableContext->proceedInsert(tables);
+        }
+
+        /*!
+         *  Присвоение записи первичного ключа из блока ключей (TableModel),
+         *  если ключи таблицы выдаёт приложение (PrimaryKey<Int, HiLoKey<N>>).
+         *  Нужно, чтобы связать дочерние записи с ещё не вставленной
+         *  родительской и вставить весь граф объектов пакетами.
+         */
+        template <class Table>
+        void assignKey(Table &row) {
+            if (_tableContext) {
+                _tableContext->assignKey(static_cast<DbTable>(&row));
+            }
+        }
+
+        template <class Table>
+        bool insert(Table &row) {
+            if (!_tableContext) {
+                return false;
+            }
+            return _tableContext->proceedInsert(
+                QVector<DbTable>() << static_cast<DbTable>(&row));
+        }
+
+        /*!
+         *  Сохранение изменённых колонок записей (TableModel): изменяются
+         *  только колонки, которым присвоено новое значение, записи
+         *  с одинаковым набором таких колонок - одним запросом.
+         */
+        template <class Table>
+        bool update(QVector<Table> &rows) {
+            if (!_tableContext) {
+                return false;
+            }
+
+            QVector<DbTable> tables;
+            tables.reserve(rows.count());
+            for (Table &row : rows) {
+                tables.append(static_cast<DbTable>(&row));
+            }
+            return _tableContext->proceedUpdate(tables);
+        }
+
+        template <class Table>
+        bool update(Table &row) {
+            if (!_tableContext) {
+                return false;
+            }
+            return _tableContext->proceedUpdate(
+                QVector<DbTable>() << static_cast<DbTable>(&row));
+        }
+
+        /*!
+         *  Отслеживание изменений записей контекстом (TableModel): изменения
+         *  всех отслеживаемых записей сохраняются ModelContext::saveChanges.
+         *  Удалённая запись перестаёт отслеживаться, копия отслеживаемой
+         *  записи отслеживается (см. trackAs).
+         */
+        template <class Table>
+        void attach(QVector<Table> &rows) {
+            for (Table &row : rows) {
+                attach(row);
+            }
+        }
+
+        template <class Table>
+        void attach(Table &row) {
+            if (_tableContext) {
+                _tableContext->attach(static_cast<DbTable>(&row));
+            }
+        }
+
+        template <class Table>
+        void detach(Table &row) {
+            if (_tableContext) {
+                _tableContext->detach(static_cast<DbTable>(&row));
+            }
         }
 
     public:
@@ -92,28 +336,49 @@ namespace jara_lib {
         DbColumn getPkColumn() const override
         { return _pkColumn; }
 
+        /*
+         * Таблица вторичного ключа может быть не задана: тогда она
+         * определяется колонкой ключа при обращении к getFkColumns.
+         * Ключи хранятся в схеме типа таблицы номерами колонок.
+         */
         void registerFK(DbTable table, DbColumn column) override {
-            if (table && column) {
-                QPair<DbTable, DbColumn> pfBinded =
-                    QPair<DbTable, DbColumn>(table, column);
-
-                if (!_fkColumns.contains(pfBinded)) {
-                    _fkColumns.append(pfBinded);
-                }
+            if (column) {
+                _schema->registerForeignKey(
+                    _columnList.indexOf(column), table);
             }
         }
 
-        ForeignKeys getFkColumns() const override
-        { return _fkColumns; }
+        /*
+         * Таблицы вторичных ключей определяются при обращении, а не в
+         * конструкторе: образец таблицы с ключом на свой же тип иначе
+         * создавался бы во время собственного создания.
+         */
+        ForeignKeys getFkColumns() const override {
+            ForeignKeys foreignKeys;
+            for (const QPair<int, DbTable> &foreignKey :
+                 as_const(_schema->getForeignKeys())) {
+                const DbColumn column = _columnList[foreignKey.first];
+                foreignKeys.append(QPair<DbTable, DbColumn>(
+                    (foreignKey.second) ? foreignKey.second
+                                        : column->getReferencedTable(),
+                    column));
+            }
+            return foreignKeys;
+        }
 
     private:
-        QString *_tableName = nullptr;
+        QString _tableName;
+        // Схема типа таблицы и собственная схема таблицы без типа
+        TableSchema *_schema = nullptr;
+        QSharedPointer<TableSchema> _ownSchema;
         DbColumn _pkColumn;
-        ForeignKeys _fkColumns;
-        DbColumns _tableColumns;
+        // Колонки в порядке объявления в структуре таблицы
+        QVector<DbColumn> _columnList;
         DbContext _tableContext = nullptr;
+        // Контекст, в котором запись отслеживается (см. attach)
+        DbContext _trackingContext = nullptr;
     };
 
 #define DECLARE_CONTEXT(Context) Context(const DbConnection& connection) : ModelContext(connection) { dbInit(); }
-#define TABLE(nm) nm = decltype(nm)(abi::__cxa_demangle(typeid(nm).name(),0,0,nullptr), this)
+#define TABLE(nm) nm = decltype(nm)(decltype(nm)::typeName(), this)
 };
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <QMutex>
+#include <QAtomicInt>
+#include "db_handler/db_model_interface.h"
+
+namespace jara_lib {
+    /*!
+     *  Схема типа таблицы: имя таблицы, имена колонок в порядке
+     *  объявления, номера колонок по именам и вторичные ключи. Схема
+     *  одна на тип таблицы (см. DECLARE_TABLE) и заполняется при
+     *  создании первого объекта этого типа. Объекты колонок хранят
+     *  только свой номер, а имена и ключи берут из схемы, поэтому
+     *  создание объекта записи не обращается ни к глобальным реестрам,
+     *  ни к блокировкам.
+     */
+    class TableSchema {
+    public:
+        explicit TableSchema(const QString &tableName = "") {
+            if (!tableName.isEmpty()) {
+                _tableName = prepareTableName(tableName);
+            }
+        }
+
+        /*! Имя таблицы по имени типа таблицы: без суффикса "Table" */
+        static QString prepareTableName(const QString &typeName) {
+            QString tableName = typeName;
+            if (tableName.contains("Table")) {
+                tableName.replace("Table", "");
+            }
+            return tableName;
+        }
+
+        /*!
+         *  Имя таблицы (TableSchema). При первом обращении имя задаётся
+         *  из имени типа таблицы без суффикса "Table".
+         */
+        QString getTableName(const QString &tableName) {
+            if (_complete.loadAcquire()) {
+                return _tableName;
+            }
+
+            QMutexLocker locker(&_mutex);
+            if (_tableName.isEmpty()) {
+                _tableName = prepareTableName(tableName);
+            }
+            return _tableName;
+        }
+
+        /*!
+         *  Имя колонки с порядковым номером ordinal (TableSchema).
+         *  Пока схема заполняется, имя добавляется под блокировкой.
+         */
+        QString getColumnName(int ordinal, const QString &columnName) {
+            if (_complete.loadAcquire()) {
+                return _columnNames[ordinal];
+            }
+
+            QMutexLocker locker(&_mutex);
+            if (ordinal >= _columnNames.count()) {
+                _columnNames.resize(ordinal + 1);
+                _columnNames[ordinal] = columnName;
+                _ordinals.insert(columnName, ordinal);
+            }
+            return _columnNames[ordinal];
+        }
+
+        /*! Имя колонки с порядковым номером ordinal (TableSchema) */
+        QString getColumnName(int ordinal) const {
+            if (_complete.loadAcquire()) {
+                return _columnNames[ordinal];
+            }
+
+            QMutexLocker locker(&_mutex);
+            return _columnNames.value(ordinal);
+        }
+
+        /*!
+         *  Переименование колонки (TableSchema): имя меняется для всех
+         *  объектов типа таблицы, поэтому колонки переименовываются до
+         *  того, как записи этого типа используются в других потоках.
+         */
+        void setColumnName(int ordinal, const QString &columnName) {
+            QMutexLocker locker(&_mutex);
+            if (ordinal < _columnNames.count()) {
+                _ordinals.remove(_columnNames[ordinal]);
+                _columnNames[ordinal] = columnName;
+                _ordinals.insert(columnName, ordinal);
+            }
+        }
+
+        /*!
+         *  Регистрация вторичного ключа (TableSchema): колонка с номером
+         *  ordinal ссылается на таблицу table. Если таблица не задана,
+         *  то она определяется колонкой ключа (getReferencedTable).
+         */
+        void registerForeignKey(int ordinal, DbTable table) {
+            if (_complete.loadAcquire()) {
+                return;
+            }
+
+            QMutexLocker locker(&_mutex);
+            const QPair<int, DbTable> foreignKey(ordinal, table);
+            if (!_foreignKeys.contains(foreignKey)) {
+                _foreignKeys.append(foreignKey);
+            }
+        }
+
+        /*! Номера колонок вторичных ключей и их таблицы (TableSchema) */
+        QVector<QPair<int, DbTable>> getForeignKeys() const {
+            if (_complete.loadAcquire()) {
+                return _foreignKeys;
+            }
+
+            QMutexLocker locker(&_mutex);
+            return _foreignKeys;
+        }
+
+        /*! Порядковый номер колонки по имени, -1 если её нет (TableSchema) */
+        int getColumnOrdinal(const QString &columnName) const {
+            if (_complete.loadAcquire()) {
+                return _ordinals.value(columnName, -1);
+            }
+
+            QMutexLocker locker(&_mutex);
+            return _ordinals.value(columnName, -1);
+        }
+
+        /*! Количество колонок типа таблицы (TableSchema) */
+        int getColumnCount() const {
+            if (_complete.loadAcquire()) {
+                return _columnNames.count();
+            }
+
+            QMutexLocker locker(&_mutex);
+            return _columnNames.count();
+        }
+
+        /*! Все колонки типа таблицы созданы, схема больше не меняется */
+        void complete()
+        { _complete.storeRelease(1); }
+
+    private:
+        QString _tableName;
+        QVector<QString> _columnNames;
+        QHash<QString, int> _ordinals;
+        QVector<QPair<int, DbTable>> _foreignKeys;
+        mutable QMutex _mutex;
+        QAtomicInt _complete;
+    };
+};
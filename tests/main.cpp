@@ -0,0 +1,28 @@
+#include <QCoreApplication>
+
+#include "model_tests.h"
+#include "thread_stress.h"
+
+/*
+ * Тесты библиотеки: make check или запуск программы.
+ * Код возврата - количество непрошедших проверок.
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    testForeignKeyReassign();
+    testDefaultColumnOrder();
+    testJoinLinksMappedParent();
+    testProjectionArity();
+    testInsertedKeys();
+    testColumnKinds();
+    testDeferredLoading();
+    testRowSetDeferred();
+    testSharedStructures();
+    testConcurrentHydration();
+
+    const int failures = testFailures().load();
+    qInfo() << "Tests finished, failed checks:" << failures;
+    return failures;
+}
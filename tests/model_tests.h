@@ -0,0 +1,306 @@
+#pragma once
+
+#include "test_check.h"
+#include "test_context.h"
+
+/*
+ * Проверки моделей на одной базе в памяти, без нескольких потоков.
+ */
+
+/* Изменение загруженного вторичного ключа и повторная загрузка записи */
+inline void testForeignKeyReassign() {
+    TestContext context;
+    context.seed(8);
+
+    QVector<EmployeeTable> employees = context.employees
+        .orderby(COL(context.employees.Id))
+        .toObjectList<EmployeeTable>();
+    CHECK(employees.count() == 8);
+    if (employees.isEmpty()) {
+        return;
+    }
+
+    EmployeeTable &employee = employees[0];
+    QSharedPointer<DepartmentTable> department = employee.DepartmentId.load();
+    CHECK(department && int(department->Id) == 1);
+
+    // Прежняя запись не должна остаться у ключа с новым значением
+    employee.DepartmentId = 4;
+    CHECK(!employee.DepartmentId.get());
+    department = employee.DepartmentId.load();
+    CHECK(department && int(department->Id) == 4 &&
+          department->Name.value() == "Research");
+
+    // Присваивание того же значения сохраняет загруженную запись
+    employee.DepartmentId = 4;
+    CHECK(employee.DepartmentId.get() == department);
+}
+
+/* Колонки без select выбираются в порядке объявления в структуре таблицы */
+inline void testDefaultColumnOrder() {
+    TestContext context;
+    context.seed(4);
+
+    const ColumnBatch &batch = context.employees.toColumns();
+    CHECK(batch.rowCount() == 4);
+    CHECK(batch.columnCount() == 4);
+    const QVector<QString> names =
+        { "Id", "DepartmentId", "FirstName", "LastName" };
+    for (int index = 0; index < batch.columnCount() &&
+         index < names.count(); ++index) {
+        CHECK(batch.column(index).name == names[index]);
+    }
+}
+
+/*
+ * Присоединённая запись связывается с родительской записью, которая
+ * уже загружена в карту записей контекста без этого присоединения.
+ */
+inline void testJoinLinksMappedParent() {
+    TestContext context;
+    context.seed(8);
+
+    QSharedPointer<DepartmentTable> department =
+        context.find<DepartmentTable>(1);
+    CHECK(department && !department->CompanyId.get());
+    if (!department) {
+        return;
+    }
+
+    QVector<EmployeeTable> employees = context.employees
+        .select(COL(context.employees.DepartmentId),
+                COL(context.departments.CompanyId),
+                COL(context.companies.Name))
+        .join<DepartmentTable>(COL(context.employees.DepartmentId) ==
+                               COL(context.departments.Id))
+        .join<CompanyTable>(COL(context.departments.CompanyId) ==
+                            COL(context.companies.Id))
+        .orderby(COL(context.employees.Id))
+        .toObjectList<EmployeeTable>();
+    CHECK(employees.count() == 8);
+    if (employees.isEmpty()) {
+        return;
+    }
+
+    CHECK(employees[0].DepartmentId.get() == department);
+    CHECK(department->CompanyId.get() &&
+          int(department->CompanyId->Id) == 1 &&
+          department->CompanyId->Name.value() == "North");
+    // Отделы, прочитанные этим запросом, тоже связаны с компаниями
+    CHECK(employees[3].DepartmentId.get() &&
+          employees[3].DepartmentId->CompanyId.get() &&
+          int(employees[3].DepartmentId->CompanyId->Id) == 2);
+}
+
+/* Проекция без select или с другим числом колонок не выполняется */
+inline void testProjectionArity() {
+    TestContext context;
+    context.seed(2);
+
+    QString error;
+    try {
+        context.employees.project<std::tuple<int, QString>>();
+    }
+    catch (const QString &message) {
+        error = message;
+    }
+    CHECK(!error.isEmpty());
+
+    error.clear();
+    try {
+        context.employees.select(COL(context.employees.Id))
+            .project<std::tuple<int, QString>>();
+    }
+    catch (const QString &message) {
+        error = message;
+    }
+    CHECK(!error.isEmpty());
+
+    struct Name { int id; QString name; };
+    error.clear();
+    try {
+        context.employees.select(COL(context.employees.Id),
+                                 COL(context.employees.FirstName),
+                                 COL(context.employees.LastName))
+            .projectInto<Name>(&Name::id, &Name::name);
+    }
+    catch (const QString &message) {
+        error = message;
+    }
+    CHECK(!error.isEmpty());
+
+    // После ошибки выражение сброшено, следующий запрос выполняется
+    const QVector<Name> names = context.employees
+        .select(COL(context.employees.Id), COL(context.employees.FirstName))
+        .orderby(COL(context.employees.Id))
+        .projectInto<Name>(&Name::id, &Name::name);
+    CHECK(names.count() == 2 && names[0].id == 1 &&
+          names[0].name == "Name1");
+}
+
+/* Ключи-счётчики вставленных записей записываются в объекты */
+inline void testInsertedKeys() {
+    TestContext context;
+    context.seed(0);
+
+    QVector<CompanyTable> companies(3);
+    for (int index = 0; index < companies.count(); ++index) {
+        companies[index].Name = "Company" + QString::number(index);
+    }
+    CHECK(context.companies.insert(companies));
+    for (int index = 0; index < companies.count(); ++index) {
+        CHECK(int(companies[index].Id) == index + 3);
+    }
+
+    QSharedPointer<CompanyTable> company = context.find<CompanyTable>(5);
+    CHECK(company && company->Name.value() == "Company2");
+}
+
+/*
+ * Связанные записи, блоки ключей и признаки отложенных и общих строк
+ * хранят только колонки ForeignKey, PrimaryKey, Deferred и Interned,
+ * имена колонок и вторичные ключи - схема типа таблицы.
+ */
+inline void testColumnKinds() {
+    TestContext context;
+    context.seed(2);
+
+    NoteTable note;
+    CHECK(note.getColumn("Id")->getKeyBlockSize() == 10);
+    CHECK(note.getColumn("Kind")->isInterned() &&
+          !note.getColumn("Kind")->isDeferred());
+    CHECK(note.getColumn("Text")->isDeferred() &&
+          !note.getColumn("Text")->isInterned());
+    CHECK(note.getColumn(3)->getModelName() == "Text");
+
+    const ForeignKeys foreignKeys = note.getFkColumns();
+    CHECK(foreignKeys.count() == 1 &&
+          foreignKeys.first().first == EmployeeTable::tablePrototype() &&
+          foreignKeys.first().second == note.getColumn("EmployeeId"));
+
+    // Обычная колонка связанную запись не хранит
+    note.getColumn("Kind")->setReference(
+        QSharedPointer<ITableModel>(new CompanyTable()));
+    CHECK(!note.getColumn("Kind")->getReference());
+
+    // Ключи записей выдаются из блока до вставки
+    QVector<NoteTable> notes(2);
+    for (NoteTable &row : notes) {
+        row.EmployeeId = 1;
+        row.Kind = "call";
+        row.Text = "Text";
+    }
+    CHECK(context.notes.insert(notes));
+    CHECK(int(notes[0].Id) > 0 && int(notes[1].Id) == int(notes[0].Id) + 1);
+
+    // Копия и перенос записи разделяют связанную запись
+    QVector<EmployeeTable> employees = context.employees
+        .include<DepartmentTable>()
+        .toObjectList<EmployeeTable>();
+    CHECK(employees.count() == 2);
+    if (employees.isEmpty()) {
+        return;
+    }
+    const EmployeeTable copy(employees[0]);
+    CHECK(copy.DepartmentId.get() &&
+          copy.DepartmentId.get() == employees[0].DepartmentId.get());
+    EmployeeTable moved(std::move(employees[0]));
+    CHECK(moved.DepartmentId.get() == copy.DepartmentId.get());
+}
+
+/*
+ * Отложенное значение загружается, только если запись прочитана
+ * запросом без этой колонки, и сразу для всех записей результата.
+ */
+inline void testDeferredLoading() {
+    TestContext context;
+    context.seed(2);
+
+    // Новая запись без ключа ничего не загружает и не меняется
+    NoteTable draft;
+    draft.registerContext(&context);
+    CHECK(draft.Text.get().isEmpty());
+    CHECK(draft.getColumn("Text")->getValueState() == ValueState::UNCHANGED);
+
+    QVector<NoteTable> notes(3);
+    for (int index = 0; index < notes.count(); ++index) {
+        notes[index].EmployeeId = 1;
+        notes[index].Kind = "call";
+        notes[index].Text = "Text" + QString::number(index);
+    }
+    CHECK(context.notes.insert(notes));
+    CHECK(notes[0].Text.get() == "Text0");
+    context.clearLoadedRows();
+
+    // Без select текст не выбирается и загружается при обращении
+    QVector<NoteTable> loaded = context.notes
+        .orderby(COL(context.notes.Id))
+        .toObjectList<NoteTable>();
+    CHECK(loaded.count() == 3);
+    for (int index = 0; index < loaded.count(); ++index) {
+        CHECK(!loaded[index].getColumn("Text")->isLoaded());
+        CHECK(loaded[index].Text.get() == "Text" + QString::number(index));
+        CHECK(loaded[index].getColumn("Text")->isLoaded());
+    }
+
+    // Выбранный текст загружен вместе с записью
+    QVector<NoteTable> selected = context.notes
+        .select(COL(context.notes.Text))
+        .orderby(COL(context.notes.Id))
+        .toObjectList<NoteTable>();
+    CHECK(selected.count() == 3);
+    if (!selected.isEmpty()) {
+        CHECK(selected[0].getColumn("Text")->isLoaded());
+        CHECK(selected[0].Text.get() == "Text0");
+    }
+
+    // Объект потока с пулом записей заново отмечает текст незагруженным
+    QVector<QString> streamed;
+    for (NoteTable &note : context.notes.stream<NoteTable>(1)) {
+        streamed.append(note.Text.get());
+    }
+    CHECK(streamed.count() == 3 && streamed.contains("Text2"));
+}
+
+/* Не выбранная отложенная колонка в RowSet не становится значением NULL */
+inline void testRowSetDeferred() {
+    TestContext context;
+    context.seed(1);
+
+    QVector<NoteTable> notes(2);
+    for (int index = 0; index < notes.count(); ++index) {
+        notes[index].EmployeeId = 1;
+        notes[index].Kind = "call";
+        notes[index].Text = "Text" + QString::number(index);
+    }
+    CHECK(context.notes.insert(notes));
+    context.clearLoadedRows();
+
+    const int text = NoteTable::rowLayout().columnOrdinal("Text");
+    const RowSet &rows = context.notes.orderby(COL(context.notes.Id))
+        .toRows<NoteTable>();
+    CHECK(rows.rowCount() == 2);
+    if (rows.rowCount() != 2) {
+        return;
+    }
+    CHECK(!rows[0].isLoaded(text) && rows[0].isLoaded(0));
+
+    NoteTable note = rows.toObject<NoteTable>(0, &context);
+    CHECK(!note.getColumn(text)->isLoaded());
+    CHECK(note.Text.get() == "Text0");
+
+    const RowSet &selected = context.notes
+        .select(COL(context.notes.Text))
+        .orderby(COL(context.notes.Id))
+        .toRows<NoteTable>();
+    CHECK(selected.rowCount() == 2 && selected[1].isLoaded(text) &&
+          selected[1].value(text).toString() == "Text1");
+
+    // Незагруженное значение объекта остаётся незагруженным, NULL - NULL
+    RowSet copies(NoteTable::rowLayout());
+    copies.append(rows.toObject<NoteTable>(1));
+    NoteTable empty;
+    copies.append(empty);
+    CHECK(!copies[0].isLoaded(text));
+    CHECK(copies[1].isLoaded(text) && copies[1].isNull(text));
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QDebug>
+#include <QAtomicInt>
+
+/*! Количество непрошедших проверок всех тестов */
+inline QAtomicInt& testFailures() {
+    static QAtomicInt failures;
+    return failures;
+}
+
+/*
+ * Проверка условия теста: непрошедшая проверка выводится вместе
+ * с местом в исходниках и учитывается в коде возврата программы.
+ * Проверки могут выполняться из нескольких потоков.
+ */
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            testFailures().ref(); \
+            qCritical() << "FAIL:" << #condition \
+                        << "at" << __FILE__ << ":" << __LINE__; \
+        } \
+    } while (false)
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "model_handler/column_types.h"
+#include "model_handler/table_model.h"
+
+using namespace jara_lib;
+
+struct EmployeeTable;
+struct DepartmentTable;
+struct CompanyTable;
+struct NoteTable;
+
+struct EmployeeTable : public TableModel {
+    DECLARE_TABLE(EmployeeTable)
+
+    PrimaryKey<Int> COLUMN(Id);
+    ForeignKey<Int, DepartmentTable> COLUMN(DepartmentId);
+    String COLUMN(FirstName);
+    String COLUMN(LastName);
+};
+
+struct DepartmentTable : public TableModel {
+    DECLARE_TABLE(DepartmentTable)
+
+    PrimaryKey<Int> COLUMN(Id);
+    ForeignKey<Int, CompanyTable> COLUMN(CompanyId);
+    String COLUMN(Name);
+};
+
+struct CompanyTable : public TableModel {
+    DECLARE_TABLE(CompanyTable)
+
+    PrimaryKey<Int> COLUMN(Id);
+    String COLUMN(Name);
+};
+
+/* Заметки о сотрудниках: ключи из блоков, общие строки, отложенный текст */
+struct NoteTable : public TableModel {
+    DECLARE_TABLE(NoteTable)
+
+    PrimaryKey<Int, HiLoKey<10>> COLUMN(Id);
+    ForeignKey<Int, EmployeeTable> COLUMN(EmployeeId);
+    Interned<String> COLUMN(Kind);
+    Deferred<String> COLUMN(Text);
+};
+
+/*
+ * Контекст тестов с базой SQLite в памяти: у каждого объекта контекста
+ * своя пустая база, таблицы создаются при создании контекста.
+ * Подключение используется только в потоке, создавшем контекст.
+ */
+struct TestContext : public ModelContext {
+    TestContext() : ModelContext(DbConnection(":memory:", DbType::SQLITE))
+    { dbInit(); }
+
+    /*! Выполнение запроса в обход моделей, например, для записи данных */
+    bool execute(const QString &command)
+    { return _connection.proceedQuery(command).isActive(); }
+
+    /*
+     * Две компании, по два отдела в каждой и employeeCount сотрудников,
+     * которые по очереди распределены по отделам.
+     */
+    void seed(int employeeCount) {
+        execute("INSERT INTO Company (Id, Name) VALUES (1, 'North'), (2, 'South')");
+        execute("INSERT INTO Department (Id, CompanyId, Name) VALUES "
+                "(1, 1, 'Sales'), (2, 1, 'Support'), (3, 2, 'Sales'), "
+                "(4, 2, 'Research')");
+        for (int employee = 1; employee <= employeeCount; ++employee) {
+            execute("INSERT INTO Employee (Id, DepartmentId, FirstName, "
+                    "LastName) VALUES (" + QString::number(employee) + ", " +
+                    QString::number((employee - 1) % 4 + 1) + ", 'Name" +
+                    QString::number(employee) + "', 'O''Hara')");
+        }
+    }
+
+    EmployeeTable TABLE(employees);
+    DepartmentTable TABLE(departments);
+    CompanyTable TABLE(companies);
+    NoteTable TABLE(notes);
+};
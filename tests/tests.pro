@@ -0,0 +1,27 @@
+QT -= gui
+QT += sql concurrent
+
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+# Исходники библиотеки собираются вместе с тестами
+include("../jara_lib/model_handler/model_handler.pri")
+include("../jara_lib/db_handler/db_handler.pri")
+
+INCLUDEPATH += $$PWD/../jara_lib
+DEPENDPATH += $$PWD/../jara_lib
+
+SOURCES += \
+        main.cpp
+
+HEADERS += \
+    model_tests.h \
+    test_check.h \
+    test_context.h \
+    thread_stress.h
+
+# Сборка для поиска гонок данных: qmake CONFIG+=tsan && make check
+tsan {
+    QMAKE_CXXFLAGS += -fsanitize=thread -g
+    QMAKE_LFLAGS += -fsanitize=thread
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QThreadPool>
+#include <QtConcurrent>
+#include "test_check.h"
+#include "test_context.h"
+
+/*
+ * Нагрузочные проверки структур библиотеки, общих для потоков.
+ * Для поиска гонок данных тесты собираются с ThreadSanitizer:
+ * qmake CONFIG+=tsan.
+ */
+
+/* Запуск worker(thread) в threadCount потоках и ожидание их завершения */
+template <typename Worker>
+void runThreads(int threadCount, Worker worker) {
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    QVector<QFuture<void>> futures;
+    for (int thread = 0; thread < threadCount; ++thread) {
+        futures.append(QtConcurrent::run(&pool, worker, thread));
+    }
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+}
+
+/*
+ * Структуры, общие для потоков, без подключения к базе: образцы
+ * таблиц и их коллекции колонок и ключей, схемы типов, таблица строк
+ * запроса, карта записей и отслеживаемые записи контекста, раскладка
+ * компактных записей.
+ */
+inline void testSharedStructures(int threadCount = 8, int iterations = 2000) {
+    ModelContext context{DbConnection()};
+    StringPool strings;
+
+    runThreads(threadCount, [&context, &strings, iterations](int thread) {
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            // Коллекции общего образца строятся при первом обращении
+            const DbTable prototype = EmployeeTable::tablePrototype();
+            CHECK(prototype->getTableColumns().count() == 4);
+            for (const QPair<DbTable, DbColumn> &foreignKey :
+                 prototype->getFkColumns()) {
+                CHECK(foreignKey.first == DepartmentTable::tablePrototype());
+            }
+
+            // Создание, копирование и перенос записей читают схему типа
+            EmployeeTable employee;
+            employee.getPkColumn()->setModelValue(
+                thread * iterations + iteration);
+            employee.FirstName = (iteration % 2) ? "Ann" : "Lee";
+            EmployeeTable copy(employee);
+            EmployeeTable moved(std::move(copy));
+            CHECK(moved.getColumnOrdinal("FirstName") == 2);
+            CHECK(moved.getColumnOrdinal("\"Employee\".\"LastName\"") == 3);
+
+            strings.intern(QString::number(iteration % 16));
+
+            // Все потоки получают из карты записей один объект записи
+            const qlonglong key = iteration % 64;
+            QSharedPointer<DepartmentTable> department =
+                QSharedPointer<DepartmentTable>::create();
+            department->getPkColumn()->setModelValue(key);
+            const QSharedPointer<ITableModel> &registered =
+                context.registerRow(department);
+            CHECK(context.findRow(DepartmentTable::modelName(), key).data() ==
+                  registered.data());
+
+            // Копия отслеживаемой записи отслеживается, удалённая - нет
+            context.attach(&moved);
+            {
+                EmployeeTable tracked(moved);
+                CHECK(tracked.getTrackingContext() == &context);
+            }
+            context.detach(&moved);
+
+            CHECK(EmployeeTable::rowLayout().columnCount() == 4);
+        }
+    });
+}
+
+/*
+ * Чтение записей в объекты в нескольких потоках одновременно. У каждого
+ * потока свой контекст и своя база в памяти, общие для потоков - схемы
+ * типов, образцы таблиц и раскладки записей, которые строятся при первом
+ * обращении из любого из потоков.
+ */
+inline void testConcurrentHydration(int threadCount = 4, int iterations = 50) {
+    const int employeeCount = 40;
+
+    runThreads(threadCount, [iterations, employeeCount](int) {
+        TestContext context;
+        context.seed(employeeCount);
+
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            // Каждый проход читает записи из базы, а не из карты записей
+            context.clearLoadedRows();
+
+            // Объекты присоединённых таблиц разделяются записями
+            QVector<EmployeeTable> employees = context.employees
+                .select(COL(context.employees.DepartmentId),
+                        COL(context.employees.FirstName),
+                        COL(context.departments.CompanyId),
+                        COL(context.departments.Name),
+                        COL(context.companies.Name))
+                .join<DepartmentTable>(COL(context.employees.DepartmentId) ==
+                                       COL(context.departments.Id))
+                .join<CompanyTable>(COL(context.departments.CompanyId) ==
+                                    COL(context.companies.Id))
+                .orderby(COL(context.employees.Id))
+                .toObjectList<EmployeeTable>();
+            CHECK(employees.count() == employeeCount);
+            for (int index = 0; index < employees.count(); ++index) {
+                EmployeeTable &employee = employees[index];
+                CHECK(int(employee.Id) == index + 1);
+                CHECK(employee.FirstName.value() ==
+                      "Name" + QString::number(index + 1));
+                CHECK(employee.DepartmentId.get() &&
+                      int(employee.DepartmentId->Id) == index % 4 + 1);
+                CHECK(employee.DepartmentId.get() &&
+                      employee.DepartmentId->CompanyId.get() &&
+                      int(employee.DepartmentId->CompanyId->Id) ==
+                          index % 4 / 2 + 1);
+            }
+            if (employees.count() > 4) {
+                CHECK(employees[0].DepartmentId.get() ==
+                      employees[4].DepartmentId.get());
+            }
+
+            // Все колонки без select и загрузка связанных записей
+            QVector<EmployeeTable> included = context.employees
+                .include<DepartmentTable>()
+                .toObjectList<EmployeeTable>();
+            CHECK(included.count() == employeeCount);
+            for (EmployeeTable &employee : included) {
+                CHECK(employee.LastName.value() == "O'Hara");
+                CHECK(employee.DepartmentId.get() &&
+                      employee.DepartmentId->Name.value() ==
+                          ((int(employee.DepartmentId) == 4) ? "Research"
+                           : (int(employee.DepartmentId) == 2) ? "Support"
+                                                               : "Sales"));
+            }
+
+            int streamed = 0;
+            for (EmployeeTable &employee :
+                 context.employees.stream<EmployeeTable>(2)) {
+                CHECK(int(employee.Id) > 0);
+                ++streamed;
+            }
+            CHECK(streamed == employeeCount);
+
+            const RowSet &rows = context.employees.toRows<EmployeeTable>();
+            CHECK(rows.rowCount() == employeeCount);
+
+            QSharedPointer<CompanyTable> company =
+                context.find<CompanyTable>(2);
+            CHECK(company && company->Name.value() == "South");
+        }
+    });
+}